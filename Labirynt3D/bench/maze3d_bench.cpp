@@ -0,0 +1,565 @@
+// Headless benchmark of the Labirynt3D obstacle field: generation, the per-frame obstacle update, the cost of
+// evaluating one obstacle's closed-form transform and the player's sphere-vs-obstacles query, across gridSize, then
+// the lattice broadphase up to gridSize 200. Checks that the closed-form transforms match glm's
+// translate * rotate * scale, that the local-space collision tests (triangles, analytic distance and its SIMD
+// kernels) agree with the octahedron mesh transformed to world space, that steady-state updates make no heap
+// allocations and that the broadphase answers like the full scan. Last, frustum culling through the static octree
+// from first-person cameras at gridSize 10 to 100, checked against testing every bounding sphere, and the
+// software occlusion culling behind it, checked by casting rays to points of culled obstacles that have to hit an
+// occluder first.
+// Usage: maze3d_bench [frames] [queries]
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/random.hpp>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <cmath>
+#include <thread>
+#include "ObstacleManager.hpp"
+#include "MeshGenerator.hpp"
+#include "Collision.hpp"
+#include "FrustumCuller.hpp"
+#include "OcclusionCuller.hpp"
+#include "OctahedronBatch.hpp"
+
+// Every heap allocation of the process goes through here, the update loop is measured by the difference
+static std::atomic<size_t> allocationCount(0);
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* block = std::malloc(size ? size : 1)) return block;
+    throw std::bad_alloc();
+}
+
+// GCC pairs the inlined free() with the replaced operator new and warns, the pairing is the intended one here
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* block) noexcept {
+    std::free(block);
+}
+
+void operator delete(void* block, std::size_t) noexcept {
+    std::free(block);
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Distance from a point to an obstacle's surface through the mesh's triangles transformed to world space, and
+// whether the point is inside (behind all 8 outward faces)
+static float worldSurfaceDistance(const Mesh& octahedron, const glm::mat4& transform, const glm::vec3& point, bool& inside) {
+    float distance = 1e30f;
+    inside = true;
+    for (size_t v = 0; v < octahedron.indices.size(); v += 3) {
+        glm::vec3 world[3];
+        for (int k = 0; k < 3; k++) {
+            world[k] = glm::vec3(transform * glm::vec4(octahedron.vertices[octahedron.indices[v + k]].position, 1.0f));
+        }
+        distance = std::min(distance, glm::length(point - closestPointTriangle(point, world[0], world[1], world[2])));
+        glm::vec3 normal = glm::cross(world[1] - world[0], world[2] - world[0]);
+        if (glm::dot(normal, point - world[0]) > 0.0f) inside = false;
+    }
+    return distance;
+}
+
+// Random sphere around a random obstacle, reaching from its center to a little past its bounding sphere
+static void randomSphere(const std::vector<Obstacle>& obstacles, std::mt19937& rng, size_t& index, glm::vec3& center,
+                         float& radius) {
+    std::uniform_int_distribution<size_t> pick(0, obstacles.size() - 1);
+    std::uniform_real_distribution<float> offset(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> radiusDist(0.005f, 0.05f);
+    index = pick(rng);
+    radius = radiusDist(rng);
+    center = obstacles[index].position +
+             glm::vec3(offset(rng), offset(rng), offset(rng)) * (obstacles[index].boundingRadius + radius);
+}
+
+// Obstacles whose closed-form transform at the manager's time differs (by more than 1e-5 in any entry) from the
+// glm::translate * glm::rotate * glm::scale chain updateObstacles used to build every frame
+static int closedFormMismatches(const ObstacleManager& manager) {
+    const float twoPi = 6.28318531f;
+    int mismatches = 0;
+    for (size_t i = 0; i < manager.getObstacles().size(); i++) {
+        const Obstacle& obstacle = manager.getObstacles()[i];
+        float angle = std::fmod(obstacle.rotationSpeed * manager.getTime(), twoPi);
+        glm::mat4 expected = glm::translate(glm::mat4(1.0f), obstacle.position);
+        expected = glm::rotate(expected, angle, obstacle.rotationAxis);
+        expected = glm::scale(expected, glm::vec3(manager.getObstacleRadius()));
+        glm::mat4 transform = manager.getTransform(i);
+        float error = 0.0f;
+        for (int c = 0; c < 4; c++) {
+            for (int r = 0; r < 4; r++) error = std::max(error, std::fabs(transform[c][r] - expected[c][r]));
+        }
+        if (error > 1e-5f) mismatches++;
+    }
+    return mismatches;
+}
+
+// Sphere tests near random obstacles through Collision (obstacle frame: the triangles and the analytic test)
+// against the mesh transformed to world space. Returns the poses where they disagree, apart from spheres within
+// 1e-5 of touching
+static int localSpaceMismatches(const ObstacleManager& manager, int samples, unsigned int seed) {
+    Mesh octahedron = MeshGenerator::generateOctahedron();
+    std::mt19937 rng(seed);
+    int mismatches = 0;
+    for (int sample = 0; sample < samples; sample++) {
+        size_t index;
+        glm::vec3 center;
+        float radius;
+        randomSphere(manager.getObstacles(), rng, index, center, radius);
+
+        bool inside;
+        float distance = worldSurfaceDistance(octahedron, manager.getTransform(index), center, inside);
+        if (std::fabs(distance - radius) <= 1e-5f) continue;
+        bool surface = Collision::checkSphereObstacleTriangles(center, radius, manager, index);
+        bool solid = Collision::checkSphereObstacleCollision(center, radius, manager, index);
+        if (surface != (distance < radius)) mismatches++;
+        if (solid != (inside || distance < radius)) mismatches++;
+    }
+    return mismatches;
+}
+
+// Every octahedron kernel against the world-space reference, with the obstacle in each lane position of a
+// 32-lane batch (the lanes before it hold copies moved out of reach). Returns false on any disagreement
+static bool checkOctahedronKernels(int samples) {
+    ObstacleManager manager;
+    manager.generateObstacles(10, 3);
+    manager.updateObstacles(1.7f); // every obstacle turned away from its axes
+    const std::vector<Obstacle>& obstacles = manager.getObstacles();
+    Mesh octahedron = MeshGenerator::generateOctahedron();
+    float scale = manager.getObstacleRadius();
+
+    std::vector<OctahedronKernel> kernels = { OctahedronKernel::Scalar };
+    if (bestOctahedronKernel() != OctahedronKernel::Scalar) kernels.push_back(OctahedronKernel::SSE);
+    if (bestOctahedronKernel() == OctahedronKernel::AVX2) kernels.push_back(OctahedronKernel::AVX2);
+
+    std::mt19937 rng(5);
+    int mismatches = 0, hits = 0, insides = 0, checked = 0;
+    OctahedronBatch batch;
+    for (int sample = 0; sample < samples; sample++) {
+        size_t index;
+        glm::vec3 center;
+        float radius;
+        randomSphere(obstacles, rng, index, center, radius);
+        bool inside;
+        glm::mat4 transform = manager.getTransform(index);
+        float distance = worldSurfaceDistance(octahedron, transform, center, inside);
+        if (std::fabs(distance - radius) <= 1e-5f) continue;
+        bool expected = inside || distance < radius;
+        int expectedLane = sample % OctahedronBatch::capacity;
+        checked++;
+        hits += expected;
+        insides += inside;
+
+        glm::mat4 away = transform;
+        away[3] += glm::vec4(10.0f, 10.0f, 10.0f, 0.0f);
+        batch.clear();
+        for (int lane = 0; lane < expectedLane; lane++) batch.add(away, -1);
+        batch.add(transform, static_cast<int>(index));
+        batch.pad();
+        for (OctahedronKernel kernel : kernels) {
+            int lane = firstOctahedronHit(center, radius, scale, batch, kernel);
+            if (lane != (expected ? expectedLane : -1)) mismatches++;
+        }
+    }
+
+    std::cout << "Octahedron kernels (";
+    for (size_t k = 0; k < kernels.size(); k++) std::cout << (k ? ", " : "") << octahedronKernelName(kernels[k]);
+    std::cout << ") vs world-space triangles: " << checked << " spheres, " << hits << " hit, " << insides
+              << " centers inside, " << mismatches << " mismatches\n";
+    return mismatches == 0;
+}
+
+// Cost of one sphere-vs-obstacle test near the obstacles (past the bounding sphere early out): the 8 triangles,
+// the analytic distance, and the analytic test on full 32-lane batches per kernel
+static void timeOctahedronTests(int samples) {
+    ObstacleManager manager;
+    manager.generateObstacles(10, 3);
+    manager.updateObstacles(1.7f);
+    const std::vector<Obstacle>& obstacles = manager.getObstacles();
+    float scale = manager.getObstacleRadius();
+    std::mt19937 rng(9);
+    std::vector<size_t> indices(samples);
+    std::vector<glm::vec3> centers(samples);
+    std::vector<float> radii(samples);
+    for (int i = 0; i < samples; i++) {
+        randomSphere(obstacles, rng, indices[i], centers[i], radii[i]);
+        radii[i] *= 0.1f; // mostly misses, so the batches run to the end
+    }
+    // the batches time the kernels alone, on transforms evaluated up front
+    std::vector<glm::mat4> transforms(samples);
+    for (int i = 0; i < samples; i++) transforms[i] = manager.getTransform(indices[i]);
+
+    size_t hits = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < samples; i++) hits += Collision::checkSphereObstacleTriangles(centers[i], radii[i], manager, indices[i]);
+    double triangleNs = secondsSince(start) * 1e9 / samples;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < samples; i++) hits += Collision::checkSphereObstacleCollision(centers[i], radii[i], manager, indices[i]);
+    double analyticNs = secondsSince(start) * 1e9 / samples;
+    std::cout << std::fixed << std::setprecision(1) << "Sphere vs obstacle: triangles " << triangleNs
+              << " ns, analytic " << analyticNs << " ns";
+
+    OctahedronBatch batch;
+    std::vector<OctahedronKernel> kernels = { OctahedronKernel::Scalar };
+    if (bestOctahedronKernel() != OctahedronKernel::Scalar) kernels.push_back(OctahedronKernel::SSE);
+    if (bestOctahedronKernel() == OctahedronKernel::AVX2) kernels.push_back(OctahedronKernel::AVX2);
+    for (OctahedronKernel kernel : kernels) {
+        size_t lanes = 0;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i + OctahedronBatch::capacity <= samples; i += OctahedronBatch::capacity) {
+            batch.clear();
+            for (int k = 0; k < OctahedronBatch::capacity; k++) batch.add(transforms[i + k], static_cast<int>(indices[i + k]));
+            batch.pad();
+            hits += firstOctahedronHit(centers[i], radii[i], scale, batch, kernel) >= 0;
+            lanes += OctahedronBatch::capacity;
+        }
+        std::cout << ", " << octahedronKernelName(kernel) << " batch " << secondsSince(start) * 1e9 / lanes << " ns";
+    }
+    std::cout << " per obstacle (" << hits << " hits)\n" << std::defaultfloat;
+}
+
+// Player moves through the lattice broadphase against the full scan main() used to run (up to
+// scanLimit obstacles, the scan takes too long beyond). Returns false when the two answers differ
+static bool runBroadphase(int gridSize, int queries, size_t scanLimit) {
+    ObstacleManager manager;
+    auto start = std::chrono::steady_clock::now();
+    manager.generateObstacles(gridSize, 1);
+    double generateSeconds = secondsSince(start);
+    size_t count = manager.getObstacles().size();
+    const float radius = 0.025f; // Player::radius
+
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> coordinate(radius, 1.0f - radius);
+    std::vector<glm::vec3> positions(queries);
+    for (auto& position : positions) position = glm::vec3(coordinate(rng), coordinate(rng), coordinate(rng));
+
+    std::vector<char> latticeHits(queries);
+    size_t tested = 0;
+    int mostTested = 0;
+    start = std::chrono::steady_clock::now();
+    for (int q = 0; q < queries; q++) {
+        int candidates = 0;
+        latticeHits[q] = Collision::checkSphereLatticeCollision(positions[q], radius, manager, &candidates);
+        tested += candidates;
+        mostTested = std::max(mostTested, candidates);
+    }
+    double latticeSeconds = secondsSince(start) / queries;
+
+    int mismatches = 0;
+    double scanSeconds = 0.0;
+    bool scanned = count <= scanLimit;
+    if (scanned) {
+        start = std::chrono::steady_clock::now();
+        for (int q = 0; q < queries; q++) {
+            bool hit = false;
+            for (size_t i = 0; i < count && !hit; i++) {
+                hit = Collision::checkSphereObstacleCollision(positions[q], radius, manager, i);
+            }
+            if (hit != (latticeHits[q] != 0)) mismatches++;
+        }
+        scanSeconds = secondsSince(start) / queries;
+    }
+
+    size_t hits = std::count(latticeHits.begin(), latticeHits.end(), 1);
+    std::cout << std::setw(8) << gridSize << std::setw(10) << count << std::fixed << std::setprecision(1)
+              << std::setw(12) << generateSeconds * 1000.0 << std::setw(12) << latticeSeconds * 1e9
+              << std::setw(12) << static_cast<double>(tested) / queries << std::setw(8) << mostTested << std::setw(10)
+              << 100.0 * hits / queries << "%";
+    if (scanned) std::cout << std::setw(14) << scanSeconds * 1e9 << std::setw(12) << mismatches;
+    else std::cout << std::setw(14) << "-" << std::setw(12) << "-";
+    std::cout << "\n";
+    return mismatches == 0;
+}
+
+// First-person cameras at random places in the cube looking in random directions, with the game's projection
+// (60 degree field of view, square viewport). Returns false when the octree's visible set is not exactly the set of
+// bounding spheres the frustum touches
+static bool runFrustumCulling(int gridSize, int poses) {
+    ObstacleManager manager;
+    manager.generateObstacles(gridSize, 1);
+    size_t count = manager.getObstacles().size();
+    FrustumCuller culler;
+    auto start = std::chrono::steady_clock::now();
+    culler.build(manager);
+    double buildSeconds = secondsSince(start);
+
+    std::mt19937 rng(13);
+    std::uniform_real_distribution<float> coordinate(0.0f, 1.0f);
+    std::vector<glm::mat4> cameras(poses);
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 1.0f, 0.01f, 100.0f);
+    for (auto& camera : cameras) {
+        glm::vec3 eye(coordinate(rng), coordinate(rng), coordinate(rng));
+        glm::vec3 front = glm::sphericalRand(1.0f);
+        glm::vec3 up = std::fabs(front.y) < 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+        camera = projection * glm::lookAt(eye, eye + front, up);
+    }
+
+    std::vector<Coin> coins; // the coins' test is a handful of spheres, the obstacles are what is measured
+    double cullSeconds = 0.0, bruteSeconds = 0.0;
+    size_t visited = 0, tested = 0, visible = 0;
+    int mismatches = 0;
+    std::vector<unsigned int> expected, got;
+    expected.reserve(count);
+    for (const auto& camera : cameras) {
+        start = std::chrono::steady_clock::now();
+        culler.cull(camera, coins);
+        cullSeconds += secondsSince(start);
+        const CullingStats& stats = culler.getStats();
+        visited += stats.nodesVisited;
+        tested += stats.obstaclesTested;
+        visible += stats.obstaclesVisible;
+
+        // every bounding sphere against the frustum, what culling replaces
+        start = std::chrono::steady_clock::now();
+        Frustum frustum(camera);
+        expected.clear();
+        for (size_t i = 0; i < count; i++) {
+            const Obstacle& obstacle = manager.getObstacles()[i];
+            if (frustum.intersectsSphere(obstacle.position, obstacle.boundingRadius)) expected.push_back(static_cast<unsigned int>(i));
+        }
+        bruteSeconds += secondsSince(start);
+
+        got = culler.getVisibleObstacles();
+        std::sort(got.begin(), got.end());
+        if (got != expected || stats.obstaclesCulled != static_cast<int>(count - got.size())) mismatches++;
+    }
+
+    std::cout << std::setw(8) << gridSize << std::setw(10) << count << std::setw(9) << culler.getNodeCount()
+              << std::fixed << std::setprecision(1) << std::setw(11) << buildSeconds * 1000.0
+              << std::setw(12) << cullSeconds * 1e6 / poses << std::setw(10) << static_cast<double>(visited) / poses
+              << std::setw(11) << static_cast<double>(tested) / poses
+              << std::setw(9) << 100.0 * (1.0 - static_cast<double>(visible) / (static_cast<double>(count) * poses)) << "%"
+              << std::setw(13) << bruteSeconds * 1e6 / poses << std::setw(12) << mismatches << "\n" << std::defaultfloat;
+    return mismatches == 0;
+}
+
+// Whether the segment from eye to point enters one of the occluders (other than skip) before reaching the point.
+// In an obstacle's frame the segment stays a segment and the obstacle is the 8 half-spaces s . x <= 1
+static bool segmentBlocked(const ObstacleManager& manager, const std::vector<unsigned int>& occluders, unsigned int skip,
+                           const glm::vec3& eye, const glm::vec3& point) {
+    float scale = manager.getObstacleRadius();
+    for (unsigned int index : occluders) {
+        if (index == skip) continue;
+        glm::mat4 transform = manager.getTransform(index);
+        glm::vec3 from = Collision::toObstacleLocal(eye, transform, scale);
+        glm::vec3 to = Collision::toObstacleLocal(point, transform, scale);
+        float enter = 0.0f, leave = 1.0f;
+        for (int octant = 0; octant < 8 && enter <= leave; octant++) {
+            glm::vec3 sign(octant & 1 ? -1.0f : 1.0f, octant & 2 ? -1.0f : 1.0f, octant & 4 ? -1.0f : 1.0f);
+            float d0 = glm::dot(sign, from) - 1.0f;
+            float d1 = glm::dot(sign, to) - 1.0f;
+            if (d0 > 0.0f && d1 > 0.0f) leave = -1.0f;
+            else if (d0 > 0.0f) enter = std::max(enter, d0 / (d0 - d1));
+            else if (d1 > 0.0f) leave = std::min(leave, d0 / (d0 - d1));
+        }
+        if (enter <= leave && enter < 1.0f - 1e-4f) return true;
+    }
+    return false;
+}
+
+// Occlusion culling behind the frustum culler from first-person cameras at random places clear of the obstacles.
+// Every culled obstacle (up to verifyLimit per frame) has its center, vertices and face centers that are on screen
+// checked for a ray from the eye that reaches them past the occluders; returns false on any
+static bool runOcclusionCulling(int gridSize, int poses, int verifyLimit) {
+    ObstacleManager manager;
+    manager.generateObstacles(gridSize, 1);
+    manager.updateObstacles(2.3f);
+    FrustumCuller frustumCuller;
+    frustumCuller.build(manager);
+    OcclusionCuller occlusionCuller;
+
+    std::mt19937 rng(17);
+    std::uniform_real_distribution<float> coordinate(0.0f, 1.0f);
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 1.0f, 0.01f, 100.0f);
+    // the player's sphere no longer fits between the obstacles of large lattices, the eye keeps a quarter spacing
+    const float clearance = std::min(0.025f, 0.25f * manager.getSpacing());
+    std::vector<Coin> coins;
+    size_t frustumVisible = 0, occluders = 0, triangles = 0, culled = 0, verified = 0;
+    double rasterizeMs = 0.0, testMs = 0.0;
+    int failures = 0;
+    for (int pose = 0; pose < poses; pose++) {
+        glm::vec3 eye;
+        do {
+            eye = glm::vec3(coordinate(rng), coordinate(rng), coordinate(rng));
+        } while (Collision::checkSphereLatticeCollision(eye, clearance, manager));
+        glm::vec3 front = glm::sphericalRand(1.0f);
+        glm::vec3 up = std::fabs(front.y) < 0.99f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+        glm::mat4 viewProjection = projection * glm::lookAt(eye, eye + front, up);
+
+        frustumCuller.cull(viewProjection, coins);
+        const std::vector<unsigned int>& candidates = frustumCuller.getVisibleObstacles();
+        occlusionCuller.cull(viewProjection, eye, manager, frustumCuller);
+        const OcclusionStats& stats = occlusionCuller.getStats();
+        frustumVisible += candidates.size();
+        occluders += stats.occluders;
+        triangles += stats.triangles;
+        culled += stats.culled;
+        rasterizeMs += stats.rasterizeMs;
+        testMs += stats.testMs;
+
+        // the culled ones are the candidates missing from the visible list, both keep the candidates' order
+        const std::vector<unsigned int>& visible = occlusionCuller.getVisibleObstacles();
+        std::vector<unsigned int> hidden;
+        for (size_t c = 0, v = 0; c < candidates.size(); c++) {
+            if (v < visible.size() && visible[v] == candidates[c]) v++;
+            else hidden.push_back(candidates[c]);
+        }
+        size_t step = std::max<size_t>(1, hidden.size() / verifyLimit);
+        for (size_t h = 0; h < hidden.size(); h += step) {
+            glm::mat4 transform = manager.getTransform(hidden[h]);
+            glm::vec3 samples[15];
+            int count = 0;
+            samples[count++] = glm::vec3(transform[3]);
+            for (int axis = 0; axis < 3; axis++) {
+                samples[count++] = glm::vec3(transform[3] + transform[axis]);
+                samples[count++] = glm::vec3(transform[3] - transform[axis]);
+            }
+            for (int octant = 0; octant < 8; octant++) {
+                glm::vec3 local(octant & 1 ? -1.0f : 1.0f, octant & 2 ? -1.0f : 1.0f, octant & 4 ? -1.0f : 1.0f);
+                samples[count++] = glm::vec3(transform * glm::vec4(local / 3.0f, 1.0f));
+            }
+            for (const glm::vec3& sample : samples) {
+                // points off screen or behind the eye cannot be seen whatever culling says
+                glm::vec4 clip = viewProjection * glm::vec4(sample, 1.0f);
+                if (clip.w <= 0.0f || std::fabs(clip.x) > clip.w || std::fabs(clip.y) > clip.w) continue;
+                if (!segmentBlocked(manager, occlusionCuller.getOccluders(), hidden[h], eye, sample)) {
+                    failures++;
+                    break;
+                }
+            }
+            verified++;
+        }
+    }
+
+    std::cout << std::setw(8) << gridSize << std::setw(10) << manager.getObstacles().size() << std::fixed
+              << std::setprecision(1) << std::setw(11) << static_cast<double>(frustumVisible) / poses
+              << std::setw(11) << static_cast<double>(occluders) / poses << std::setw(11)
+              << static_cast<double>(triangles) / poses << std::setw(9)
+              << (frustumVisible ? 100.0 * culled / frustumVisible : 0.0) << "%" << std::setw(12)
+              << rasterizeMs * 1000.0 / poses << std::setw(10) << testMs * 1000.0 / poses << std::setw(10) << verified
+              << std::setw(10) << failures << "\n" << std::defaultfloat;
+    return failures == 0;
+}
+
+int main(int argc, char** argv) {
+    int frames = argc >= 2 ? std::max(1, std::atoi(argv[1])) : 20;
+    int queries = argc >= 3 ? std::max(1, std::atoi(argv[2])) : 200;
+    const int gridSizes[] = { 5, 10, 20, 30, 40 };
+
+    bool ok = checkOctahedronKernels(200000);
+    timeOctahedronTests(200000);
+    std::cout << "\n";
+
+    std::cout << std::setw(8) << "gridSize" << std::setw(10) << "obstacles" << std::setw(12) << "gen ms"
+              << std::setw(12) << "update ms" << std::setw(12) << "pose ns" << std::setw(10) << "allocs"
+              << std::setw(14) << "us/move" << std::setw(12) << "mismatches" << "\n";
+
+    for (int gridSize : gridSizes) {
+        ObstacleManager manager;
+        auto start = std::chrono::steady_clock::now();
+        manager.generateObstacles(gridSize, 1);
+        double generateSeconds = secondsSince(start);
+        size_t count = manager.getObstacles().size();
+
+        // one warm-up update, the remaining ones are the steady state
+        manager.updateObstacles(1.0f / 60.0f);
+        size_t allocationsBefore = allocationCount.load();
+        start = std::chrono::steady_clock::now();
+        for (int frame = 0; frame < frames; frame++) manager.updateObstacles(1.0f / 60.0f);
+        double updateSeconds = secondsSince(start) / frames;
+        size_t allocations = allocationCount.load() - allocationsBefore;
+
+        // what collision pays per obstacle it looks at now that the update no longer builds transforms
+        glm::vec4 sink(0.0f);
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; i++) sink += manager.getTransform(i)[0];
+        double poseSeconds = secondsSince(start) / count;
+        int poseMismatches = closedFormMismatches(manager);
+
+        // the player's move check as main() runs it: every obstacle, bounding sphere first
+        std::mt19937 rng(7);
+        std::uniform_real_distribution<float> coordinate(0.0f, 1.0f);
+        std::vector<glm::vec3> positions(queries);
+        for (auto& position : positions) position = glm::vec3(coordinate(rng), coordinate(rng), coordinate(rng));
+        size_t hits = 0;
+        start = std::chrono::steady_clock::now();
+        for (const auto& position : positions) {
+            for (size_t i = 0; i < count; i++) {
+                if (Collision::checkSphereObstacleCollision(position, 0.025f, manager, i)) {
+                    hits++;
+                    break;
+                }
+            }
+        }
+        double moveSeconds = secondsSince(start) / queries;
+
+        int mismatches = localSpaceMismatches(manager, 10000, static_cast<unsigned int>(gridSize));
+        std::cout << std::setw(8) << gridSize << std::setw(10) << count << std::fixed << std::setprecision(3)
+                  << std::setw(12) << generateSeconds * 1000.0 << std::setw(12) << updateSeconds * 1000.0
+                  << std::setw(12) << std::setprecision(1) << poseSeconds * 1e9 << std::setw(10) << allocations
+                  << std::setw(14) << std::setprecision(2) << moveSeconds * 1e6 << std::setw(12) << mismatches << "\n";
+
+        if (allocations != 0) {
+            std::cout << "  FAIL: " << allocations << " heap allocations in " << frames << " steady-state updates\n";
+            ok = false;
+        }
+        if (mismatches != 0) {
+            std::cout << "  FAIL: the local-space test disagrees with the world-space triangles\n";
+            ok = false;
+        }
+        if (poseMismatches != 0 || sink.x != sink.x) {
+            std::cout << "  FAIL: " << poseMismatches << " closed-form transforms differ from translate * rotate * scale\n";
+            ok = false;
+        }
+    }
+
+    std::cout << "\nLattice broadphase\n";
+    std::cout << std::setw(8) << "gridSize" << std::setw(10) << "obstacles" << std::setw(12) << "gen ms"
+              << std::setw(12) << "ns/move" << std::setw(12) << "tested" << std::setw(8) << "max" << std::setw(11) << "hits"
+              << std::setw(14) << "scan ns/move" << std::setw(12) << "mismatches" << "\n";
+    const int broadphaseSizes[] = { 5, 10, 20, 40, 100, 200 };
+    for (int gridSize : broadphaseSizes) {
+        if (!runBroadphase(gridSize, queries * 50, 64000)) {
+            std::cout << "  FAIL: the broadphase disagrees with the full scan\n";
+            ok = false;
+        }
+    }
+
+    std::cout << "\nFrustum culling (static octree, " << FrustumCuller::leafSize << " obstacles per leaf)\n";
+    std::cout << std::setw(8) << "gridSize" << std::setw(10) << "obstacles" << std::setw(9) << "nodes"
+              << std::setw(11) << "build ms" << std::setw(12) << "us/frame" << std::setw(10) << "visited"
+              << std::setw(11) << "tested" << std::setw(10) << "culled" << std::setw(13) << "all us/frame"
+              << std::setw(12) << "mismatches" << "\n";
+    const int cullingSizes[] = { 10, 20, 40, 70, 100 };
+    for (int gridSize : cullingSizes) {
+        if (!runFrustumCulling(gridSize, std::max(1, frames))) {
+            std::cout << "  FAIL: the octree's visible set differs from testing every obstacle\n";
+            ok = false;
+        }
+    }
+
+    std::cout << "\nOcclusion culling (" << OcclusionCuller().getWidth() << " x " << OcclusionCuller().getHeight()
+              << " depth buffer, " << std::max(1u, std::thread::hardware_concurrency()) << " threads)\n";
+    std::cout << std::setw(8) << "gridSize" << std::setw(10) << "obstacles" << std::setw(11) << "in frustum"
+              << std::setw(11) << "occluders" << std::setw(11) << "triangles" << std::setw(10) << "culled"
+              << std::setw(12) << "raster us" << std::setw(10) << "test us" << std::setw(10) << "verified"
+              << std::setw(10) << "failures" << "\n";
+    for (int gridSize : cullingSizes) {
+        if (!runOcclusionCulling(gridSize, std::max(1, frames), 500)) {
+            std::cout << "  FAIL: an obstacle culled as hidden can be seen past the occluders\n";
+            ok = false;
+        }
+    }
+    return ok ? 0 : 1;
+}
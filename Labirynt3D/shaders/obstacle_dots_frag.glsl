@@ -3,8 +3,7 @@ out vec4 FragColor;
 
 in vec3 FragPos;
 in vec3 Normal;
-
-uniform vec3 objectColor;
+in vec3 ObjectColor;
 
 void main() {
     vec3 patternPos = fract(FragPos * 120.0); // Scale factor for dot density
@@ -18,7 +17,7 @@ void main() {
     float dotPattern = 1.0 - step(dotSize, maxDist);
     
     // Mix between object color and black based on dot pattern
-    vec3 baseColor = objectColor;
+    vec3 baseColor = ObjectColor;
     vec3 dotColor = mix(baseColor, vec3(0.0, 0.0, 0.0), dotPattern);
     
     FragColor = vec4(dotColor, 1.0);
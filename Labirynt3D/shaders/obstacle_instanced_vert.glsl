@@ -0,0 +1,45 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoords;
+
+// Index of the instance's obstacle, its static data is three texels of obstacleData, one column of a band of
+// three rows: (position, rotation speed in radians per second), (unit rotation axis, -), (color, -)
+layout (location = 3) in uint aObstacle;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoords;
+out vec3 ObjectColor;
+
+uniform mat4 view;
+uniform mat4 projection;
+uniform float time;
+uniform float obstacleRadius;
+uniform sampler2D obstacleData;
+uniform int obstaclesPerRow;
+
+// Axis-angle rotation, the same closed form ObstacleManager::obstacleTransform evaluates for collision
+mat3 rotation(vec3 axis, float angle) {
+    float c = cos(angle);
+    float s = sin(angle);
+    vec3 t = (1.0 - c) * axis;
+    return mat3(c + t.x * axis.x, t.x * axis.y + s * axis.z, t.x * axis.z - s * axis.y,
+                t.y * axis.x - s * axis.z, c + t.y * axis.y, t.y * axis.z + s * axis.x,
+                t.z * axis.x + s * axis.y, t.z * axis.y - s * axis.x, c + t.z * axis.z);
+}
+
+void main() {
+    int obstacle = int(aObstacle);
+    ivec2 texel = ivec2(obstacle % obstaclesPerRow, obstacle / obstaclesPerRow * 3);
+    vec4 positionSpeed = texelFetch(obstacleData, texel, 0);
+    vec3 axis = texelFetch(obstacleData, texel + ivec2(0, 1), 0).xyz;
+    mat3 rotate = rotation(axis, mod(positionSpeed.w * time, 6.28318531));
+
+    FragPos = positionSpeed.xyz + rotate * (aPos * obstacleRadius);
+    Normal = rotate * aNormal;
+    TexCoords = aTexCoords;
+    ObjectColor = texelFetch(obstacleData, texel + ivec2(0, 2), 0).rgb;
+
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+}
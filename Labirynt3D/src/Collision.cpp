@@ -3,6 +3,7 @@
 #include "Collision.hpp"
 #include "ObstacleManager.hpp"
 #include <algorithm>
+#include <cmath>
 
 bool Collision::checkSphereTriangleCollision(const glm::vec3& sphereCenter, float radius,
                                            const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
@@ -12,19 +13,41 @@ bool Collision::checkSphereTriangleCollision(const glm::vec3& sphereCenter, floa
 }
 
 bool Collision::checkSphereObstacleCollision(const glm::vec3& sphereCenter, float radius,
-                                           const Obstacle& obstacle) {
+                                           const ObstacleManager& obstacles, size_t index) {
+    const Obstacle& obstacle = obstacles.getObstacles()[index];
+
+    // First check bounding sphere for early out
+    float distanceToCenter = glm::length(sphereCenter - obstacle.position);
+    if (distanceToCenter > (radius + obstacle.boundingRadius)) {
+        return false;
+    }
+
+    // In the obstacle's frame the octahedron is the unit one and the sphere's radius shrinks by the scale
+    float scale = obstacles.getObstacleRadius();
+    glm::vec3 localCenter = toObstacleLocal(sphereCenter, obstacles.getTransform(index), scale);
+    return unitOctahedronDistance(localCenter) < radius / scale;
+}
+
+bool Collision::checkSphereObstacleTriangles(const glm::vec3& sphereCenter, float radius,
+                                           const ObstacleManager& obstacles, size_t index) {
+    const Obstacle& obstacle = obstacles.getObstacles()[index];
+
     // First check bounding sphere for early out
     float distanceToCenter = glm::length(sphereCenter - obstacle.position);
     if (distanceToCenter > (radius + obstacle.boundingRadius)) {
         return false;
     }
     
-    // Check all triangles
-    for (size_t i = 0; i < obstacle.triangleVertices.size(); i += 3) {
-        if (checkSphereTriangleCollision(sphereCenter, radius,
-                                        obstacle.triangleVertices[i],
-                                        obstacle.triangleVertices[i+1],
-                                        obstacle.triangleVertices[i+2])) {
+    // Check all triangles of the unit octahedron, in its frame the sphere's radius shrinks by the scale
+    float scale = obstacles.getObstacleRadius();
+    glm::vec3 localCenter = toObstacleLocal(sphereCenter, obstacles.getTransform(index), scale);
+    float localRadius = radius / scale;
+    const auto& triangles = ObstacleManager::getCanonicalTriangles();
+    for (size_t i = 0; i < triangles.size(); i += 3) {
+        if (checkSphereTriangleCollision(localCenter, localRadius,
+                                        triangles[i],
+                                        triangles[i+1],
+                                        triangles[i+2])) {
             return true;
         }
     }
@@ -32,6 +55,79 @@ bool Collision::checkSphereObstacleCollision(const glm::vec3& sphereCenter, floa
     return false;
 }
 
+bool Collision::checkSphereLatticeCollision(const glm::vec3& sphereCenter, float radius,
+                                          const ObstacleManager& obstacles, int* tested, OctahedronKernel kernel) {
+    int count = 0;
+    if (tested) *tested = 0;
+    if (obstacles.getObstacles().empty()) return false;
+
+    // lattice coordinates of the sphere's box grown by an obstacle's bounding radius
+    float spacing = obstacles.getSpacing();
+    float reach = radius + obstacles.getObstacles()[0].boundingRadius;
+    glm::vec3 low = (sphereCenter - glm::vec3(reach)) / spacing;
+    glm::vec3 high = (sphereCenter + glm::vec3(reach)) / spacing;
+    int last = obstacles.getGridSize() - 1;
+    int i0 = std::max(0, static_cast<int>(std::ceil(low.x))), i1 = std::min(last, static_cast<int>(std::floor(high.x)));
+    int j0 = std::max(0, static_cast<int>(std::ceil(low.y))), j1 = std::min(last, static_cast<int>(std::floor(high.y)));
+    int k0 = std::max(0, static_cast<int>(std::ceil(low.z))), k1 = std::min(last, static_cast<int>(std::floor(high.z)));
+
+    // the candidates go through the SIMD test a batch at a time, a full batch is tested before more are gathered.
+    // Only these obstacles get their transforms evaluated
+    float scale = obstacles.getObstacleRadius();
+    OctahedronBatch batch;
+    auto flush = [&]() {
+        count += batch.count;
+        batch.pad();
+        bool hit = firstOctahedronHit(sphereCenter, radius, scale, batch, kernel) >= 0;
+        batch.clear();
+        return hit;
+    };
+
+    // the nearest lattice point is the likeliest hit, it is tested alone before the rest are gathered
+    glm::vec3 nearest = sphereCenter / spacing + glm::vec3(0.5f);
+    int ni = static_cast<int>(std::floor(nearest.x)), nj = static_cast<int>(std::floor(nearest.y)), nk = static_cast<int>(std::floor(nearest.z));
+    bool nearestInRange = ni >= i0 && ni <= i1 && nj >= j0 && nj <= j1 && nk >= k0 && nk <= k1;
+    if (nearestInRange) {
+        int index = obstacles.obstacleIndex(ni, nj, nk);
+        if (index >= 0) {
+            count++;
+            if (checkSphereObstacleCollision(sphereCenter, radius, obstacles, index)) {
+                if (tested) *tested = count;
+                return true;
+            }
+        }
+    }
+
+    bool collision = false;
+    for (int i = i0; i <= i1 && !collision; i++) {
+        for (int j = j0; j <= j1 && !collision; j++) {
+            for (int k = k0; k <= k1; k++) {
+                if (nearestInRange && i == ni && j == nj && k == nk) continue;
+                int index = obstacles.obstacleIndex(i, j, k);
+                if (index < 0) continue;
+                batch.add(obstacles.getTransform(index), index);
+                if (batch.isFull() && flush()) {
+                    collision = true;
+                    break;
+                }
+            }
+        }
+    }
+    if (!collision && batch.count > 0) collision = flush();
+    if (tested) *tested = count;
+    return collision;
+}
+
+glm::vec3 Collision::toObstacleLocal(const glm::vec3& point, const glm::mat4& transform, float scale) {
+    // the first three columns are the rotated axes times the scale, so projecting on them and dividing by the
+    // squared scale applies the inverse rotation and scale at once
+    glm::vec3 offset = point - glm::vec3(transform[3]);
+    float inverseSquare = 1.0f / (scale * scale);
+    return glm::vec3(glm::dot(glm::vec3(transform[0]), offset),
+                     glm::dot(glm::vec3(transform[1]), offset),
+                     glm::dot(glm::vec3(transform[2]), offset)) * inverseSquare;
+}
+
 bool Collision::checkWorldBoundaries(const glm::vec3& position, float radius, glm::vec3& newPosition) {
     newPosition = position;
     bool collision = false;
@@ -3,16 +3,37 @@
 
 #include <glm/glm.hpp>
 #include <vector>
+#include <cstddef>
 #include "ClosestPointTriangle.h"
-struct Obstacle;
+#include "OctahedronBatch.hpp"
+class ObstacleManager;
 
 class Collision {
 public:
     static bool checkSphereTriangleCollision(const glm::vec3& sphereCenter, float radius,
                                            const glm::vec3& a, const glm::vec3& b, const glm::vec3& c);
     
+    // Obstacle at index in the manager. The sphere is moved into the obstacle's frame (inverse rotation and
+    // scale) and tested against the unit octahedron |x| + |y| + |z| <= 1 by its exact signed distance, a sphere
+    // inside the solid counts as a collision
     static bool checkSphereObstacleCollision(const glm::vec3& sphereCenter, float radius,
-                                           const Obstacle& obstacle);
+                                           const ObstacleManager& obstacles, size_t index);
+
+    // Reference for the analytic test: the same frame, the unit octahedron's 8 triangles. Only the surface
+    // counts, a sphere deep inside does not collide
+    static bool checkSphereObstacleTriangles(const glm::vec3& sphereCenter, float radius,
+                                           const ObstacleManager& obstacles, size_t index);
+
+    // Broadphase over the obstacle lattice: only obstacles whose bounding spheres the sphere's box can reach are
+    // tested, at most 27 while the sphere's radius stays under 3/4 of the lattice spacing, the nearest lattice
+    // point first, the rest go through the analytic test in SIMD batches. tested (if given) receives the number of
+    // obstacles run through it
+    static bool checkSphereLatticeCollision(const glm::vec3& sphereCenter, float radius,
+                                          const ObstacleManager& obstacles, int* tested = nullptr,
+                                          OctahedronKernel kernel = bestOctahedronKernel());
+
+    // Point in the frame of an obstacle drawn as transform = translate * rotate * scale(scale)
+    static glm::vec3 toObstacleLocal(const glm::vec3& point, const glm::mat4& transform, float scale);
     
     static bool checkWorldBoundaries(const glm::vec3& position, float radius, glm::vec3& newPosition);
     
@@ -0,0 +1,198 @@
+#include "FrustumCuller.hpp"
+#include "ObstacleManager.hpp"
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+
+Frustum::Frustum(const glm::mat4& viewProjection) {
+    // rows of the matrix (glm stores columns), a point is inside when -w <= x, y, z <= w in clip space
+    glm::vec4 row[4];
+    for (int r = 0; r < 4; r++) {
+        row[r] = glm::vec4(viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r]);
+    }
+    planes[0] = row[3] + row[0];
+    planes[1] = row[3] - row[0];
+    planes[2] = row[3] + row[1];
+    planes[3] = row[3] - row[1];
+    planes[4] = row[3] + row[2];
+    planes[5] = row[3] - row[2];
+    for (auto& plane : planes) {
+        plane = plane * (1.0f / glm::length(glm::vec3(plane)));
+    }
+}
+
+bool Frustum::intersectsSphere(const glm::vec3& center, float radius) const {
+    for (const auto& plane : planes) {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) return false;
+    }
+    return true;
+}
+
+void FrustumCuller::build(const ObstacleManager& obstacles) {
+    const std::vector<Obstacle>& all = obstacles.getObstacles();
+    nodes.clear();
+    order.resize(all.size());
+    std::iota(order.begin(), order.end(), 0u);
+    spheres.resize(all.size());
+    visibleObstacles.clear();
+    visibleObstacles.reserve(all.size());
+    visibleSpheres.clear();
+    visibleSpheres.reserve(all.size());
+    visibleLeaves.clear();
+    if (all.empty()) return;
+
+    // bounding spheres by obstacle index while the order is being sorted, by position in the order afterwards
+    for (size_t i = 0; i < all.size(); i++) {
+        spheres[i] = glm::vec4(all[i].position, all[i].boundingRadius);
+    }
+    Node root;
+    root.first = 0;
+    root.count = static_cast<int>(all.size());
+    nodes.push_back(root);
+    std::vector<unsigned int> scratch(all.size());
+    buildNode(0, scratch);
+
+    std::vector<glm::vec4> byIndex;
+    byIndex.swap(spheres);
+    spheres.resize(order.size());
+    for (size_t i = 0; i < order.size(); i++) spheres[i] = byIndex[order[i]];
+}
+
+void FrustumCuller::buildNode(int nodeIndex, std::vector<unsigned int>& scratch) {
+    // nodes grows below, so the node is addressed by index throughout
+    const int first = nodes[nodeIndex].first;
+    const int count = nodes[nodeIndex].count;
+
+    glm::vec3 boxMin(1e30f), boxMax(-1e30f), centerMin(1e30f), centerMax(-1e30f);
+    for (int i = first; i < first + count; i++) {
+        const glm::vec4& sphere = spheres[order[i]];
+        glm::vec3 center(sphere);
+        boxMin = glm::min(boxMin, center - glm::vec3(sphere.w));
+        boxMax = glm::max(boxMax, center + glm::vec3(sphere.w));
+        centerMin = glm::min(centerMin, center);
+        centerMax = glm::max(centerMax, center);
+    }
+    nodes[nodeIndex].boxMin = boxMin;
+    nodes[nodeIndex].boxMax = boxMax;
+    nodes[nodeIndex].firstChild = -1;
+    nodes[nodeIndex].childCount = 0;
+    if (count <= leafSize) return;
+
+    // split at the middle of the centers' box, the octant of each obstacle is one bit per axis
+    glm::vec3 split = (centerMin + centerMax) * 0.5f;
+    auto octant = [&](unsigned int obstacle) {
+        const glm::vec4& sphere = spheres[obstacle];
+        return (sphere.x > split.x ? 1 : 0) | (sphere.y > split.y ? 2 : 0) | (sphere.z > split.z ? 4 : 0);
+    };
+    int octantCount[8] = {};
+    for (int i = first; i < first + count; i++) octantCount[octant(order[i])]++;
+    int nonEmpty = 0;
+    for (int o = 0; o < 8; o++) nonEmpty += octantCount[o] > 0;
+    if (nonEmpty < 2) return; // every center in one place, nothing to split
+
+    int start[8];
+    for (int o = 0, offset = first; o < 8; o++) {
+        start[o] = offset;
+        offset += octantCount[o];
+    }
+    int next[8];
+    std::copy(start, start + 8, next);
+    for (int i = first; i < first + count; i++) scratch[next[octant(order[i])]++] = order[i];
+    std::copy(scratch.begin() + first, scratch.begin() + first + count, order.begin() + first);
+
+    int firstChild = static_cast<int>(nodes.size());
+    for (int o = 0; o < 8; o++) {
+        if (octantCount[o] == 0) continue;
+        Node child;
+        child.first = start[o];
+        child.count = octantCount[o];
+        nodes.push_back(child);
+    }
+    nodes[nodeIndex].firstChild = firstChild;
+    nodes[nodeIndex].childCount = nonEmpty;
+    for (int c = 0; c < nonEmpty; c++) buildNode(firstChild + c, scratch);
+}
+
+void FrustumCuller::cull(const glm::mat4& viewProjection, const std::vector<Coin>& coins) {
+    Frustum frustum(viewProjection);
+    stats = CullingStats();
+    visibleObstacles.clear();
+    visibleSpheres.clear();
+    visibleLeaves.clear();
+    visibleCoins.clear();
+
+    const unsigned int allPlanes = 0x3F;
+    if (!nodes.empty()) {
+        stack.clear();
+        stack.push_back({ 0, allPlanes });
+    }
+    while (!stack.empty()) {
+        StackEntry entry = stack.back();
+        stack.pop_back();
+        const Node& node = nodes[entry.node];
+        stats.nodesVisited++;
+
+        // drop the planes the box is entirely inside of, stop at one it is entirely outside of
+        unsigned int mask = entry.planeMask;
+        bool outside = false;
+        for (int p = 0; p < 6 && !outside; p++) {
+            if (!(mask & (1u << p))) continue;
+            const glm::vec4& plane = frustum.planes[p];
+            glm::vec3 normal(plane);
+            glm::vec3 ahead(normal.x >= 0.0f ? node.boxMax.x : node.boxMin.x,
+                            normal.y >= 0.0f ? node.boxMax.y : node.boxMin.y,
+                            normal.z >= 0.0f ? node.boxMax.z : node.boxMin.z);
+            glm::vec3 behind(normal.x >= 0.0f ? node.boxMin.x : node.boxMax.x,
+                             normal.y >= 0.0f ? node.boxMin.y : node.boxMax.y,
+                             normal.z >= 0.0f ? node.boxMin.z : node.boxMax.z);
+            if (glm::dot(normal, ahead) + plane.w < 0.0f) outside = true;
+            else if (glm::dot(normal, behind) + plane.w >= 0.0f) mask &= ~(1u << p);
+        }
+        if (outside) continue;
+
+        // a node inside every plane passes mask 0 down, its leaves take their obstacles without a test
+        if (node.firstChild >= 0) {
+            for (int c = 0; c < node.childCount; c++) stack.push_back({ node.firstChild + c, mask });
+            continue;
+        }
+        size_t first = visibleObstacles.size();
+        if (mask == 0) {
+            visibleObstacles.insert(visibleObstacles.end(), order.begin() + node.first,
+                                    order.begin() + node.first + node.count);
+            visibleSpheres.insert(visibleSpheres.end(), spheres.begin() + node.first,
+                                  spheres.begin() + node.first + node.count);
+        } else {
+            for (int i = node.first; i < node.first + node.count; i++) {
+                stats.obstaclesTested++;
+                glm::vec3 center(spheres[i]);
+                bool inside = true;
+                for (int p = 0; p < 6 && inside; p++) {
+                    if (!(mask & (1u << p))) continue;
+                    const glm::vec4& plane = frustum.planes[p];
+                    inside = glm::dot(glm::vec3(plane), center) + plane.w >= -spheres[i].w;
+                }
+                if (inside) {
+                    visibleObstacles.push_back(order[i]);
+                    visibleSpheres.push_back(spheres[i]);
+                }
+            }
+        }
+        if (visibleObstacles.size() > first) {
+            visibleLeaves.push_back({ node.boxMin, node.boxMax, static_cast<int>(first),
+                                      static_cast<int>(visibleObstacles.size() - first) });
+        }
+    }
+    stats.obstaclesVisible = static_cast<int>(visibleObstacles.size());
+    stats.obstaclesCulled = static_cast<int>(order.size() - visibleObstacles.size());
+
+    // a level has a handful of coins, each is tested directly
+    for (size_t i = 0; i < coins.size(); i++) {
+        if (coins[i].collected) continue;
+        if (frustum.intersectsSphere(coins[i].position, coins[i].radius)) {
+            visibleCoins.push_back(static_cast<unsigned int>(i));
+            stats.coinsVisible++;
+        } else {
+            stats.coinsCulled++;
+        }
+    }
+}
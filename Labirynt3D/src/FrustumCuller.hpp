@@ -0,0 +1,86 @@
+#ifndef FRUSTUMCULLER_HPP
+#define FRUSTUMCULLER_HPP
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "CoinManager.hpp"
+
+class ObstacleManager;
+
+// The six planes of a view-projection matrix (left, right, bottom, top, near, far), normals pointing inward
+// and normalized, so dot(plane, (p, 1)) is the signed distance of p
+struct Frustum {
+    glm::vec4 planes[6];
+
+    explicit Frustum(const glm::mat4& viewProjection);
+    bool intersectsSphere(const glm::vec3& center, float radius) const;
+};
+
+struct CullingStats {
+    int nodesVisited = 0;
+    int obstaclesTested = 0; // bounding spheres tested one by one, in leaves the frustum cuts through
+    int obstaclesVisible = 0;
+    int obstaclesCulled = 0;
+    int coinsVisible = 0;
+    int coinsCulled = 0;     // coins still to collect that are out of view
+};
+
+// A leaf of the octree in the visible list: the box around its bounding spheres and the obstacles of it that
+// passed, visibleObstacles[first, first + count)
+struct VisibleLeaf {
+    glm::vec3 boxMin;
+    glm::vec3 boxMax;
+    int first;
+    int count;
+};
+
+// Static octree over the obstacles' bounding spheres, built once per level (obstacles spin in place, their
+// bounding spheres never move). cull() walks it against the camera's frustum: nodes outside a plane are dropped
+// whole, nodes inside every plane are taken whole, only leaves the frustum cuts test their obstacles one by one.
+// The visible list is also kept leaf by leaf, so the occlusion pass can settle a leaf at once, and with the
+// bounding spheres alongside, so that pass reads them in order rather than from the scattered obstacles
+class FrustumCuller {
+public:
+    static const int leafSize = 32;
+
+    void build(const ObstacleManager& obstacles);
+    // Fills the visible obstacle and coin lists (indices into getObstacles() and the coin vector)
+    void cull(const glm::mat4& viewProjection, const std::vector<Coin>& coins);
+
+    const std::vector<unsigned int>& getVisibleObstacles() const { return visibleObstacles; }
+    // Bounding sphere (center, radius) of each visible obstacle
+    const std::vector<glm::vec4>& getVisibleSpheres() const { return visibleSpheres; }
+    const std::vector<VisibleLeaf>& getVisibleLeaves() const { return visibleLeaves; }
+    const std::vector<unsigned int>& getVisibleCoins() const { return visibleCoins; }
+    const CullingStats& getStats() const { return stats; }
+    size_t getNodeCount() const { return nodes.size(); }
+
+private:
+    struct Node {
+        glm::vec3 boxMin;
+        glm::vec3 boxMax;
+        int firstChild; // children are stored together, -1 for a leaf
+        int childCount;
+        int first;      // the node's obstacles are order[first, first + count)
+        int count;
+    };
+
+    struct StackEntry {
+        int node;
+        unsigned int planeMask; // planes the node's parent was not yet inside of
+    };
+
+    std::vector<Node> nodes;
+    std::vector<unsigned int> order;    // obstacle indices, each node's subtree contiguous
+    std::vector<glm::vec4> spheres;     // bounding sphere (center, radius) of order[i]
+    std::vector<StackEntry> stack;      // reused by cull
+    std::vector<unsigned int> visibleObstacles;
+    std::vector<glm::vec4> visibleSpheres;
+    std::vector<VisibleLeaf> visibleLeaves;
+    std::vector<unsigned int> visibleCoins;
+    CullingStats stats;
+
+    void buildNode(int nodeIndex, std::vector<unsigned int>& scratch);
+};
+
+#endif
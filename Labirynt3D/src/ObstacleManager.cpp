@@ -1,12 +1,47 @@
 #include "ObstacleManager.hpp"
 #include "MeshGenerator.hpp"
-#include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/random.hpp>
+#include <cmath>
 
 // generates randomly rotated obstacles 
 
+const std::array<glm::vec3, ObstacleManager::canonicalVertexCount>& ObstacleManager::getCanonicalTriangles() {
+    static const std::array<glm::vec3, canonicalVertexCount> triangles = []() {
+        std::array<glm::vec3, canonicalVertexCount> result;
+        Mesh mesh = MeshGenerator::generateOctahedron();
+        for (size_t i = 0; i < result.size(); i++) {
+            result[i] = mesh.vertices[mesh.indices[i]].position;
+        }
+        return result;
+    }();
+    return triangles;
+}
+
 ObstacleManager::ObstacleManager() 
-    : gridSize(5), seed(0), spacing(0.2f), obstacleRadius(0.13f) {
+    : gridSize(5), seed(0), spacing(0.2f), obstacleRadius(0.13f), elapsedTime(0.0) {
+}
+
+glm::mat4 ObstacleManager::obstacleTransform(const Obstacle& obstacle, float radius, float time) {
+    // angle wrapped like GLSL mod() so the collision frame matches the drawn one
+    const float twoPi = 6.28318531f;
+    float angle = obstacle.rotationSpeed * time;
+    angle -= twoPi * std::floor(angle / twoPi);
+    float c = std::cos(angle);
+    float s = std::sin(angle);
+
+    // axis-angle rotation (as glm::rotate builds it) with the scale folded into the columns
+    const glm::vec3& axis = obstacle.rotationAxis;
+    glm::vec3 t = (1.0f - c) * axis;
+    glm::mat4 transform(1.0f);
+    transform[0] = glm::vec4(glm::vec3(c + t.x * axis.x, t.x * axis.y + s * axis.z, t.x * axis.z - s * axis.y) * radius, 0.0f);
+    transform[1] = glm::vec4(glm::vec3(t.y * axis.x - s * axis.z, c + t.y * axis.y, t.y * axis.z + s * axis.x) * radius, 0.0f);
+    transform[2] = glm::vec4(glm::vec3(t.z * axis.x + s * axis.y, t.z * axis.y - s * axis.x, c + t.z * axis.z) * radius, 0.0f);
+    transform[3] = glm::vec4(obstacle.position, 1.0f);
+    return transform;
+}
+
+glm::mat4 ObstacleManager::getTransform(size_t index) const {
+    return obstacleTransform(obstacles[index], obstacleRadius, getTime());
 }
 
 void ObstacleManager::generateObstacles(int gridSize, int seed) {
@@ -17,10 +52,11 @@ void ObstacleManager::generateObstacles(int gridSize, int seed) {
     spacing = (gridSize > 1) ? 1.0f / (gridSize - 1) : 1.0f;
     obstacleRadius = (gridSize > 1) ? spacing * 0.5f : 0.1f;
     
+    elapsedTime = 0.0;
     obstacles.clear();
+    obstacles.reserve(gridSize > 0 ? static_cast<size_t>(gridSize) * gridSize * gridSize - 1 : 0);
     
     std::mt19937 rng(seed);
-    std::uniform_real_distribution<float> dist(0.0f, 360.0f);
     std::uniform_real_distribution<float> speedDist(0.3f, 0.7f);
     
     for (int i = 0; i < gridSize; i++) {
@@ -39,26 +75,12 @@ void ObstacleManager::generateObstacles(int gridSize, int seed) {
                     obstacle.color.g = 0.7f * obstacle.position.y + 0.3f;
                     obstacle.color.b = 0.7f * obstacle.position.z + 0.3f;
                     
-                    // Random rotation
-                    float angleX = dist(rng);
-                    float angleY = dist(rng);
-                    float angleZ = dist(rng);
-
                     // Random rotation axis for continuous rotation
-                    obstacle.rotationAxis = glm::sphericalRand(1.0f); 
+                    obstacle.rotationAxis = glm::normalize(glm::sphericalRand(1.0f));
                     obstacle.rotationSpeed = speedDist(rng); 
-                    obstacle.currentRotation = 0.0f;
-                    
-                    obstacle.transform = glm::mat4(1.0f);
-                    obstacle.transform = glm::translate(obstacle.transform, obstacle.position);
-                    obstacle.transform = glm::rotate(obstacle.transform, glm::radians(angleX), glm::vec3(1.0f, 0.0f, 0.0f));
-                    obstacle.transform = glm::rotate(obstacle.transform, glm::radians(angleY), glm::vec3(0.0f, 1.0f, 0.0f));
-                    obstacle.transform = glm::rotate(obstacle.transform, glm::radians(angleZ), glm::vec3(0.0f, 0.0f, 1.0f));
-                    obstacle.transform = glm::scale(obstacle.transform, glm::vec3(obstacleRadius));
                     
                     obstacle.boundingRadius = obstacleRadius * 1.5f; // Conservative bounding sphere
                     
-                    generateTriangleVertices(obstacle);
                     obstacles.push_back(obstacle);
                 }
             }
@@ -66,41 +88,14 @@ void ObstacleManager::generateObstacles(int gridSize, int seed) {
     }
 }
 
-void ObstacleManager::updateObstacles(float deltaTime) {
-    for (auto& obstacle : obstacles) {
-        // Update rotation angle based on time and speed
-        obstacle.currentRotation += obstacle.rotationSpeed * deltaTime;
-        
-        if (obstacle.currentRotation > 2 * 3.14159f) {
-            obstacle.currentRotation -= 2 * 3.14159f;
-        }
-        
-        // Rebuild transform with updated rotation
-        obstacle.transform = glm::mat4(1.0f);
-        obstacle.transform = glm::translate(obstacle.transform, obstacle.position);
-        obstacle.transform = glm::rotate(obstacle.transform, obstacle.currentRotation, obstacle.rotationAxis);
-        obstacle.transform = glm::scale(obstacle.transform, glm::vec3(obstacleRadius));
-        
-        generateTriangleVertices(obstacle);
-    }
+int ObstacleManager::obstacleIndex(int i, int j, int k) const {
+    if (obstacles.empty() || i < 0 || j < 0 || k < 0 || i >= gridSize || j >= gridSize || k >= gridSize) return -1;
+    // generation order: k fastest, then j, then i, with (0, 0, 0) left out
+    int linear = (i * gridSize + j) * gridSize + k;
+    return linear - 1;
 }
 
-void ObstacleManager::generateTriangleVertices(Obstacle& obstacle) {
-    Mesh octahedron = MeshGenerator::generateOctahedron();
-    obstacle.triangleVertices.clear();
-    
-    for (size_t i = 0; i < octahedron.indices.size(); i += 3) {
-        glm::vec3 a = octahedron.vertices[octahedron.indices[i]].position;
-        glm::vec3 b = octahedron.vertices[octahedron.indices[i+1]].position;
-        glm::vec3 c = octahedron.vertices[octahedron.indices[i+2]].position;
-        
-        // Transform vertices to world space
-        glm::vec4 worldA = obstacle.transform * glm::vec4(a, 1.0f);
-        glm::vec4 worldB = obstacle.transform * glm::vec4(b, 1.0f);
-        glm::vec4 worldC = obstacle.transform * glm::vec4(c, 1.0f);
-        
-        obstacle.triangleVertices.push_back(glm::vec3(worldA));
-        obstacle.triangleVertices.push_back(glm::vec3(worldB));
-        obstacle.triangleVertices.push_back(glm::vec3(worldC));
-    }
-}
\ No newline at end of file
+void ObstacleManager::updateObstacles(float deltaTime) {
+    // the rotation is a function of time alone, the GPU and collision evaluate it when they need it
+    elapsedTime += deltaTime;
+}
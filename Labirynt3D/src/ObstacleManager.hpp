@@ -3,27 +3,45 @@
 
 #include <glm/glm.hpp>
 #include <vector>
+#include <array>
 #include <random>
+#include <cstddef>
 
 struct Obstacle {
     glm::vec3 position;
     glm::vec3 color;
-    glm::mat4 transform;
-    std::vector<glm::vec3> triangleVertices;
     float boundingRadius;
 
+    // Spins about the unit rotationAxis at rotationSpeed radians per second from the level's start,
+    // ObstacleManager::obstacleTransform gives the transform at any time
     glm::vec3 rotationAxis;
     float rotationSpeed;
-    float currentRotation;
 };
 
 class ObstacleManager {
 public:
+    static const int canonicalVertexCount = 24;
+
     ObstacleManager();
+
+    // Triangles of the unit octahedron every obstacle is a scaled, rotated copy of (3 vertices each), taken from
+    // MeshGenerator once. Collision tests run against these in the obstacle's own frame
+    static const std::array<glm::vec3, canonicalVertexCount>& getCanonicalTriangles();
     
+    // translate(position) * rotate(rotationSpeed * time mod 2 pi, rotationAxis) * scale(radius), the same closed
+    // form obstacle_instanced_vert.glsl evaluates for drawing
+    static glm::mat4 obstacleTransform(const Obstacle& obstacle, float radius, float time);
+
     void generateObstacles(int gridSize, int seed = 0);
+    // Only advances the clock, transforms are evaluated on demand for the obstacles that need them
     void updateObstacles(float deltaTime);
     const std::vector<Obstacle>& getObstacles() const { return obstacles; }
+    // Transform of the obstacle at index at the current time
+    glm::mat4 getTransform(size_t index) const;
+    float getTime() const { return static_cast<float>(elapsedTime); }
+    // Index into getObstacles() of the obstacle at lattice point (i, j, k), placed at (i, j, k) * spacing.
+    // -1 outside the lattice and at the empty start corner
+    int obstacleIndex(int i, int j, int k) const;
     
     int getGridSize() const { return gridSize; }
     int getSeed() const { return seed; }
@@ -36,8 +54,7 @@ private:
     int seed;
     float spacing;
     float obstacleRadius;
-    
-    void generateTriangleVertices(Obstacle& obstacle);
+    double elapsedTime; // seconds since generateObstacles
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,295 @@
+#include "OcclusionCuller.hpp"
+#include "ObstacleManager.hpp"
+#include "FrustumCuller.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+namespace {
+
+// nearest view depth a vertex or sphere may have and still be projected, anything nearer counts as visible
+const float nearDepth = 1e-4f;
+const float farAway = 3.0e38f;
+const int leafChunk = 32; // leaves per work item, at most a thousand candidates
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+template <typename Work>
+void OcclusionCuller::parallelFor(int count, unsigned int threadCount, const Work& work) {
+    if (count <= 0) return;
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::min(threadCount, static_cast<unsigned int>(count));
+    if (threadCount == 1) {
+        for (int i = 0; i < count; i++) work(i);
+        return;
+    }
+    if (!pool || pool->size() < threadCount) pool.reset(new WorkerPool(threadCount));
+    std::atomic<int> next(0);
+    pool->run([&](unsigned int) {
+        for (int i = next++; i < count; i = next++) work(i);
+    });
+}
+
+OcclusionCuller::OcclusionCuller(int width, int height, float occluderReach)
+    : width(std::max(1, width)), height(std::max(1, height)), occluderReach(occluderReach) {
+    depth.assign(static_cast<size_t>(this->width) * this->height, farAway);
+    tilesX = (this->width + tileSize - 1) / tileSize;
+    tilesY = (this->height + tileSize - 1) / tileSize;
+    tileFarDepth.assign(static_cast<size_t>(tilesX) * tilesY, farAway);
+    tileNearDepth.assign(static_cast<size_t>(tilesX) * tilesY, farAway);
+}
+
+void OcclusionCuller::cull(const glm::mat4& viewProjection, const glm::vec3& eye, const ObstacleManager& obstacles,
+                           const FrustumCuller& frustum, unsigned int threadCount) {
+    const std::vector<unsigned int>& candidates = frustum.getVisibleObstacles();
+    const std::vector<VisibleLeaf>& leaves = frustum.getVisibleLeaves();
+    stats = OcclusionStats();
+    occluders.clear();
+    triangles.clear();
+    if (candidates.size() < static_cast<size_t>(minCandidates)) {
+        visibleObstacles.assign(candidates.begin(), candidates.end());
+        return;
+    }
+    if (candidates.size() < static_cast<size_t>(parallelCandidates)) threadCount = 1;
+    for (int r = 0; r < 4; r++) {
+        rows[r] = glm::vec4(viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r]);
+        absRows[r] = glm::abs(glm::vec3(rows[r]));
+    }
+    rowLengths = glm::vec3(glm::length(glm::vec3(rows[0])), glm::length(glm::vec3(rows[1])), glm::length(glm::vec3(rows[3])));
+
+    auto start = std::chrono::steady_clock::now();
+    selectOccluders(viewProjection, eye, obstacles);
+    setupTriangles(viewProjection, obstacles);
+    int bandCount = (height + bandRows - 1) / bandRows;
+    parallelFor(bandCount, threadCount, [&](int band) {
+        rasterizeBand(band * bandRows, std::min(height, (band + 1) * bandRows));
+    });
+    stats.occluders = static_cast<int>(occluders.size());
+    stats.triangles = static_cast<int>(triangles.size());
+    stats.rasterizeMs = millisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    const std::vector<glm::vec4>& spheres = frustum.getVisibleSpheres();
+    int leafCount = static_cast<int>(leaves.size());
+    hidden.assign(candidates.size(), 0);
+    std::atomic<int> tested(0);
+    if (!triangles.empty()) {
+        int chunkCount = (leafCount + leafChunk - 1) / leafChunk;
+        parallelFor(chunkCount, threadCount, [&](int chunk) {
+            int end = std::min(leafCount, (chunk + 1) * leafChunk);
+            int oneByOne = 0;
+            for (int l = chunk * leafChunk; l < end; l++) {
+                // the leaf's box holds every bounding sphere of the leaf: behind the occluders everywhere it
+                // covers, they are all hidden, with nothing in front of it anywhere, all visible
+                const VisibleLeaf& leaf = leaves[l];
+                glm::vec3 center = (leaf.boxMin + leaf.boxMax) * 0.5f;
+                glm::vec3 half = leaf.boxMax - center;
+                glm::vec3 spread(glm::dot(absRows[0], half), glm::dot(absRows[1], half), glm::dot(absRows[3], half));
+                ScreenRect rect;
+                if (project(center, spread, rect)) {
+                    if (isHidden(rect)) {
+                        std::fill(hidden.begin() + leaf.first, hidden.begin() + leaf.first + leaf.count, 1);
+                        continue;
+                    }
+                    if (isClear(rect)) continue;
+                }
+                for (int i = leaf.first; i < leaf.first + leaf.count; i++) {
+                    hidden[i] = project(glm::vec3(spheres[i]), spheres[i].w * rowLengths, rect) && isHidden(rect);
+                }
+                oneByOne += leaf.count;
+            }
+            tested += oneByOne;
+        });
+    }
+    int candidateCount = static_cast<int>(candidates.size());
+    visibleObstacles.clear();
+    for (int i = 0; i < candidateCount; i++) {
+        if (!hidden[i]) visibleObstacles.push_back(candidates[i]);
+    }
+    stats.tested = tested;
+    stats.culled = candidateCount - static_cast<int>(visibleObstacles.size());
+    stats.testMs = millisecondsSince(start);
+}
+
+void OcclusionCuller::selectOccluders(const glm::mat4& viewProjection, const glm::vec3& eye,
+                                      const ObstacleManager& obstacles) {
+    // the lattice points within reach of the eye, in view and wholly in front of it
+    occluders.clear();
+    if (obstacles.getObstacles().empty()) return;
+    Frustum frustum(viewProjection);
+    float spacing = obstacles.getSpacing();
+    float reach = occluderReach * spacing;
+    int last = obstacles.getGridSize() - 1;
+    int i0 = std::max(0, static_cast<int>(std::ceil((eye.x - reach) / spacing)));
+    int i1 = std::min(last, static_cast<int>(std::floor((eye.x + reach) / spacing)));
+    int j0 = std::max(0, static_cast<int>(std::ceil((eye.y - reach) / spacing)));
+    int j1 = std::min(last, static_cast<int>(std::floor((eye.y + reach) / spacing)));
+    int k0 = std::max(0, static_cast<int>(std::ceil((eye.z - reach) / spacing)));
+    int k1 = std::min(last, static_cast<int>(std::floor((eye.z + reach) / spacing)));
+    for (int i = i0; i <= i1; i++) {
+        for (int j = j0; j <= j1; j++) {
+            for (int k = k0; k <= k1; k++) {
+                int index = obstacles.obstacleIndex(i, j, k);
+                if (index < 0) continue;
+                const Obstacle& obstacle = obstacles.getObstacles()[index];
+                if (glm::length(obstacle.position - eye) > reach) continue;
+                if (!frustum.intersectsSphere(obstacle.position, obstacle.boundingRadius)) continue;
+                occluders.push_back(static_cast<unsigned int>(index));
+            }
+        }
+    }
+}
+
+void OcclusionCuller::setupTriangles(const glm::mat4& viewProjection, const ObstacleManager& obstacles) {
+    triangles.clear();
+    const auto& canonical = ObstacleManager::getCanonicalTriangles();
+    for (unsigned int index : occluders) {
+        glm::mat4 toClip = viewProjection * obstacles.getTransform(index);
+        for (size_t v = 0; v < canonical.size(); v += 3) {
+            ScreenTriangle triangle;
+            triangle.farDepth = 0.0f;
+            bool behind = false;
+            for (int k = 0; k < 3; k++) {
+                glm::vec4 clip = toClip * glm::vec4(canonical[v + k], 1.0f);
+                // a triangle crossing the eye's plane is left out, the buffer only ever loses occluders
+                if (clip.w <= nearDepth) {
+                    behind = true;
+                    break;
+                }
+                triangle.v[k] = glm::vec2((clip.x / clip.w * 0.5f + 0.5f) * width, (clip.y / clip.w * 0.5f + 0.5f) * height);
+                triangle.farDepth = std::max(triangle.farDepth, clip.w);
+            }
+            if (behind) continue;
+
+            // counter-clockwise on screen faces the eye, the front faces alone cover the convex octahedron
+            glm::vec2 e1 = triangle.v[1] - triangle.v[0];
+            glm::vec2 e2 = triangle.v[2] - triangle.v[0];
+            if (e1.x * e2.y - e1.y * e2.x <= 0.0f) continue;
+
+            float minY = std::min(triangle.v[0].y, std::min(triangle.v[1].y, triangle.v[2].y));
+            float maxY = std::max(triangle.v[0].y, std::max(triangle.v[1].y, triangle.v[2].y));
+            triangle.minY = std::max(0, static_cast<int>(std::ceil(minY - 0.5f)));
+            triangle.maxY = std::min(height - 1, static_cast<int>(std::floor(maxY - 0.5f)));
+            if (triangle.minY > triangle.maxY) continue;
+            triangles.push_back(triangle);
+        }
+    }
+}
+
+void OcclusionCuller::rasterizeBand(int firstRow, int endRow) {
+    std::fill(depth.begin() + static_cast<size_t>(firstRow) * width, depth.begin() + static_cast<size_t>(endRow) * width,
+              farAway);
+    for (const ScreenTriangle& triangle : triangles) {
+        int y0 = std::max(triangle.minY, firstRow);
+        int y1 = std::min(triangle.maxY, endRow - 1);
+        if (y0 > y1) continue;
+        float minX = std::min(triangle.v[0].x, std::min(triangle.v[1].x, triangle.v[2].x));
+        float maxX = std::max(triangle.v[0].x, std::max(triangle.v[1].x, triangle.v[2].x));
+        int x0 = std::max(0, static_cast<int>(std::ceil(minX - 0.5f)));
+        int x1 = std::min(width - 1, static_cast<int>(std::floor(maxX - 0.5f)));
+        if (x0 > x1) continue;
+
+        // edge functions a * x + b * y + c, positive inside. A pixel counts only when its whole square is inside:
+        // each edge function at its center is at least half the square's extent along the edge's normal
+        float a[3], b[3], c[3], margin[3];
+        for (int e = 0; e < 3; e++) {
+            const glm::vec2& from = triangle.v[e];
+            const glm::vec2& to = triangle.v[(e + 1) % 3];
+            a[e] = from.y - to.y;
+            b[e] = to.x - from.x;
+            c[e] = -(a[e] * from.x + b[e] * from.y);
+            margin[e] = 0.5f * (std::fabs(a[e]) + std::fabs(b[e]));
+        }
+        for (int y = y0; y <= y1; y++) {
+            float cy = y + 0.5f;
+            float cx = x0 + 0.5f;
+            float e0 = a[0] * cx + b[0] * cy + c[0] - margin[0];
+            float e1 = a[1] * cx + b[1] * cy + c[1] - margin[1];
+            float e2 = a[2] * cx + b[2] * cy + c[2] - margin[2];
+            float* row = &depth[static_cast<size_t>(y) * width];
+            for (int x = x0; x <= x1; x++) {
+                if (e0 >= 0.0f && e1 >= 0.0f && e2 >= 0.0f) row[x] = std::min(row[x], triangle.farDepth);
+                e0 += a[0];
+                e1 += a[1];
+                e2 += a[2];
+            }
+        }
+    }
+
+    // the band holds whole tile rows, so its tiles' depth ranges are its own to write
+    for (int ty = firstRow / tileSize; ty * tileSize < endRow; ty++) {
+        for (int tx = 0; tx < tilesX; tx++) {
+            float nearest = farAway, farthest = 0.0f;
+            for (int y = ty * tileSize; y < std::min(endRow, (ty + 1) * tileSize); y++) {
+                const float* row = &depth[static_cast<size_t>(y) * width];
+                for (int x = tx * tileSize; x < std::min(width, (tx + 1) * tileSize); x++) {
+                    nearest = std::min(nearest, row[x]);
+                    farthest = std::max(farthest, row[x]);
+                }
+            }
+            tileNearDepth[static_cast<size_t>(ty) * tilesX + tx] = nearest;
+            tileFarDepth[static_cast<size_t>(ty) * tilesX + tx] = farthest;
+        }
+    }
+}
+
+bool OcclusionCuller::project(const glm::vec3& center, const glm::vec3& spread, ScreenRect& rect) const {
+    // view depth range of the volume
+    glm::vec4 point(center, 1.0f);
+    float w = glm::dot(rows[3], point);
+    rect.nearest = w - spread.z;
+    rect.farthest = w + spread.z;
+    if (rect.nearest <= nearDepth) return false;
+
+    // screen rectangle bounding the volume, dividing each clip coordinate's extremes by the depth that
+    // pushes them outward
+    float lo[2], hi[2];
+    for (int axis = 0; axis < 2; axis++) {
+        float value = glm::dot(rows[axis], point);
+        float low = value - spread[axis];
+        float high = value + spread[axis];
+        lo[axis] = low / (low < 0.0f ? rect.nearest : rect.farthest) * 0.5f + 0.5f;
+        hi[axis] = high / (high > 0.0f ? rect.nearest : rect.farthest) * 0.5f + 0.5f;
+    }
+    float x0f = std::floor(lo[0] * width), x1f = std::floor(hi[0] * width);
+    float y0f = std::floor(lo[1] * height), y1f = std::floor(hi[1] * height);
+    if (x1f < 0.0f || y1f < 0.0f || x0f >= width || y0f >= height) return false;
+    rect.x0 = std::max(0, static_cast<int>(x0f));
+    rect.x1 = std::min(width - 1, static_cast<int>(x1f));
+    rect.y0 = std::max(0, static_cast<int>(y0f));
+    rect.y1 = std::min(height - 1, static_cast<int>(y1f));
+    return true;
+}
+
+bool OcclusionCuller::isHidden(const ScreenRect& rect) const {
+    // tiles wholly nearer than the volume need no pixel reads, the others are checked over the rectangle's part
+    for (int ty = rect.y0 / tileSize; ty <= rect.y1 / tileSize; ty++) {
+        for (int tx = rect.x0 / tileSize; tx <= rect.x1 / tileSize; tx++) {
+            if (tileFarDepth[static_cast<size_t>(ty) * tilesX + tx] < rect.nearest) continue;
+            int yEnd = std::min(rect.y1, ty * tileSize + tileSize - 1);
+            int xEnd = std::min(rect.x1, tx * tileSize + tileSize - 1);
+            for (int y = std::max(rect.y0, ty * tileSize); y <= yEnd; y++) {
+                const float* row = &depth[static_cast<size_t>(y) * width];
+                for (int x = std::max(rect.x0, tx * tileSize); x <= xEnd; x++) {
+                    if (row[x] >= rect.nearest) return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool OcclusionCuller::isClear(const ScreenRect& rect) const {
+    for (int ty = rect.y0 / tileSize; ty <= rect.y1 / tileSize; ty++) {
+        for (int tx = rect.x0 / tileSize; tx <= rect.x1 / tileSize; tx++) {
+            if (tileNearDepth[static_cast<size_t>(ty) * tilesX + tx] <= rect.farthest) return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,102 @@
+#ifndef OCCLUSIONCULLER_HPP
+#define OCCLUSIONCULLER_HPP
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+#include "WorkerPool.hpp"
+
+class ObstacleManager;
+class FrustumCuller;
+
+struct OcclusionStats {
+    int occluders = 0;     // obstacles rasterized into the depth buffer
+    int triangles = 0;     // their front faces that reached the buffer
+    int tested = 0;        // bounding spheres tested against it one by one
+    int culled = 0;        // of those, hidden behind the occluders
+    double rasterizeMs = 0.0;
+    double testMs = 0.0;
+};
+
+// Software occlusion culling for the first-person view. The obstacles of the lattice within occluderReach
+// spacings of the eye are rasterized, as their rotated octahedra, into a low-resolution buffer of view depths;
+// then the candidates (the frustum's visible list) are tested against it, each octree leaf of them first as a
+// whole through its box and one by one only when the box is neither hidden nor in front of everything. Both sides are
+// conservative: an occluder fills only the pixels its triangles cover entirely, at each triangle's farthest
+// depth, and a sphere is culled only when every pixel its screen rectangle touches holds something nearer than
+// its nearest point. Each 8 x 8 tile also keeps its nearest and farthest depth, so a volume behind a whole tile
+// is settled without reading its pixels, and one in front of every tile it touches is visible at once. Bands of rows are rasterized, and runs of leaves tested, on a pool of threadCount
+// workers (0 - one per hardware thread) kept between frames once there are parallelCandidates candidates; below
+// minCandidates the pass costs more than the draws it could save and every candidate stays visible
+class OcclusionCuller {
+public:
+    static const int tileSize = 8;
+    static const int bandRows = 16;             // a whole number of tile rows
+    static const int minCandidates = 1024;
+    static const int parallelCandidates = 8192; // waking the workers costs about what testing this many does
+
+    OcclusionCuller(int width = 128, int height = 128, float occluderReach = 3.0f);
+
+    // The candidates are the frustum culler's visible obstacles, tested leaf by leaf
+    void cull(const glm::mat4& viewProjection, const glm::vec3& eye, const ObstacleManager& obstacles,
+              const FrustumCuller& frustum, unsigned int threadCount = 0);
+
+    // The candidates that are not hidden, in their order
+    const std::vector<unsigned int>& getVisibleObstacles() const { return visibleObstacles; }
+    const std::vector<unsigned int>& getOccluders() const { return occluders; }
+    const OcclusionStats& getStats() const { return stats; }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    // View depth of the nearest occluder covering pixel (x, y), a huge value where none does. A skipped pass
+    // leaves the buffer of the last one that ran
+    float depthAt(int x, int y) const { return depth[static_cast<size_t>(y) * width + x]; }
+
+private:
+    // A front-facing occluder triangle in pixels, y up, with its farthest view depth
+    struct ScreenTriangle {
+        glm::vec2 v[3];
+        float farDepth;
+        int minY, maxY; // rows of pixel centers it can cover
+    };
+
+    // Pixels and view depths a volume can cover
+    struct ScreenRect {
+        float nearest, farthest;
+        int x0, x1, y0, y1;
+    };
+
+    int width;
+    int height;
+    float occluderReach;
+
+    std::vector<float> depth;
+    std::vector<float> tileFarDepth;  // farthest depth of each tile's pixels
+    std::vector<float> tileNearDepth; // nearest depth of each tile's pixels
+    int tilesX, tilesY;
+    std::vector<unsigned int> occluders;
+    std::vector<ScreenTriangle> triangles;
+    std::vector<char> hidden; // per candidate
+    std::vector<unsigned int> visibleObstacles;
+    OcclusionStats stats;
+    std::unique_ptr<WorkerPool> pool; // started by the first pass that has enough candidates
+    glm::vec4 rows[4];    // rows of this frame's view-projection, clip = dot(row, (p, 1))
+    glm::vec3 absRows[4]; // |xyz| of each row, how far a box of unit half extent moves that clip coordinate
+    glm::vec3 rowLengths; // length of the x, y and w rows' xyz, how far a unit sphere moves those coordinates
+
+    void selectOccluders(const glm::mat4& viewProjection, const glm::vec3& eye, const ObstacleManager& obstacles);
+    void setupTriangles(const glm::mat4& viewProjection, const ObstacleManager& obstacles);
+    // Runs work(i) for every i in [0, count) on the pool (or the calling thread alone) taking items from a counter
+    template <typename Work>
+    void parallelFor(int count, unsigned int threadCount, const Work& work);
+    void rasterizeBand(int firstRow, int endRow);
+    // spread - how far the x, y and w clip coordinates of the volume around center can be from the center's.
+    // False when the volume reaches the eye's plane or lies off the screen
+    bool project(const glm::vec3& center, const glm::vec3& spread, ScreenRect& rect) const;
+    // Every pixel of the rectangle holds something nearer than the volume
+    bool isHidden(const ScreenRect& rect) const;
+    // No tile the rectangle touches holds anything as near as the volume's farthest point
+    bool isClear(const ScreenRect& rect) const;
+};
+
+#endif
@@ -0,0 +1,267 @@
+#include "OctahedronBatch.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define OCTAHEDRON_BATCH_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang compile the AVX2 kernel for its own target only, the rest of the file stays baseline x86
+#if defined(OCTAHEDRON_BATCH_X86) && (defined(__GNUC__) || defined(__clang__))
+#define OCTAHEDRON_BATCH_AVX2 __attribute__((target("avx2")))
+#else
+#define OCTAHEDRON_BATCH_AVX2
+#endif
+
+void OctahedronBatch::add(const glm::mat4& transform, int obstacleIndex) {
+    px[count] = transform[3].x;
+    py[count] = transform[3].y;
+    pz[count] = transform[3].z;
+    for (int column = 0; column < 3; column++) {
+        for (int row = 0; row < 3; row++) {
+            axes[column * 3 + row][count] = transform[column][row];
+        }
+    }
+    index[count] = obstacleIndex;
+    count++;
+}
+
+void OctahedronBatch::pad() {
+    // an obstacle a billion units away with an identity frame, no sphere of the game reaches it
+    int padded = blockCount() * blockSize;
+    for (int lane = count; lane < padded; lane++) {
+        px[lane] = py[lane] = pz[lane] = 1e9f;
+        for (int axis = 0; axis < 9; axis++) {
+            axes[axis][lane] = (axis % 4 == 0) ? 1.0f : 0.0f;
+        }
+        index[lane] = -1;
+    }
+}
+
+float unitOctahedronDistance(const glm::vec3& point) {
+    // by symmetry the nearest point lies on the face of the point's octant, the triangle x + y + z = 1
+    glm::vec3 p = glm::abs(point);
+    float m = p.x + p.y + p.z - 1.0f;
+    glm::vec3 q;
+    if (3.0f * p.x < m) q = p;
+    else if (3.0f * p.y < m) q = glm::vec3(p.y, p.z, p.x);
+    else if (3.0f * p.z < m) q = glm::vec3(p.z, p.x, p.y);
+    else return m * 0.57735027f; // the projection falls inside the face (or the point is inside)
+
+    // outside the face's edge opposite the vertex q.x sits nearest to: distance to that edge
+    float k = glm::clamp(0.5f * (q.z - q.y + 1.0f), 0.0f, 1.0f);
+    return glm::length(glm::vec3(q.x, q.y - 1.0f + k, q.z - k));
+}
+
+namespace {
+
+const float sqrt3 = 1.7320508f;
+
+// The sphere test of every kernel, in the obstacle's frame with p = |local center| and r the local radius:
+// inside the solid, within r of the face plane where the projection lands on the face, or within r of one
+// of the face's three edges. Only the last needs a distance, and only squared
+bool laneHits(const OctahedronBatch& batch, int lane, const glm::vec3& center, float inverseScaleSquare, float r) {
+    float ox = center.x - batch.px[lane];
+    float oy = center.y - batch.py[lane];
+    float oz = center.z - batch.pz[lane];
+    float x = std::fabs((batch.axes[0][lane] * ox + batch.axes[1][lane] * oy + batch.axes[2][lane] * oz) * inverseScaleSquare);
+    float y = std::fabs((batch.axes[3][lane] * ox + batch.axes[4][lane] * oy + batch.axes[5][lane] * oz) * inverseScaleSquare);
+    float z = std::fabs((batch.axes[6][lane] * ox + batch.axes[7][lane] * oy + batch.axes[8][lane] * oz) * inverseScaleSquare);
+
+    float m = x + y + z - 1.0f;
+    bool overFace = 3.0f * x >= m && 3.0f * y >= m && 3.0f * z >= m;
+    if (m <= 0.0f || (overFace && m < r * sqrt3)) return true;
+
+    float t = std::min(std::max((y - x + 1.0f) * 0.5f, 0.0f), 1.0f);
+    float a = x - 1.0f + t;
+    float b = y - t;
+    float edgeXY = a * a + b * b + z * z;
+    t = std::min(std::max((z - y + 1.0f) * 0.5f, 0.0f), 1.0f);
+    a = y - 1.0f + t;
+    b = z - t;
+    float edgeYZ = x * x + a * a + b * b;
+    t = std::min(std::max((x - z + 1.0f) * 0.5f, 0.0f), 1.0f);
+    a = z - 1.0f + t;
+    b = x - t;
+    float edgeZX = y * y + a * a + b * b;
+    return std::min(edgeXY, std::min(edgeYZ, edgeZX)) < r * r;
+}
+
+int firstHitScalar(const glm::vec3& center, float inverseScaleSquare, float r, const OctahedronBatch& batch) {
+    for (int lane = 0; lane < batch.count; lane++) {
+        if (laneHits(batch, lane, center, inverseScaleSquare, r)) return lane;
+    }
+    return -1;
+}
+
+int lowestBit(unsigned mask) {
+#ifdef _MSC_VER
+    unsigned long bit;
+    _BitScanForward(&bit, mask);
+    return static_cast<int>(bit);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+#ifdef OCTAHEDRON_BATCH_X86
+
+// Four lanes of laneHits, same operations in the same order
+inline unsigned hitMaskSSE(const OctahedronBatch& batch, int e, __m128 cx, __m128 cy, __m128 cz, __m128 inverse,
+                           __m128 faceLimit, __m128 radiusSquare) {
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 three = _mm_set1_ps(3.0f);
+
+    __m128 ox = _mm_sub_ps(cx, _mm_load_ps(&batch.px[e]));
+    __m128 oy = _mm_sub_ps(cy, _mm_load_ps(&batch.py[e]));
+    __m128 oz = _mm_sub_ps(cz, _mm_load_ps(&batch.pz[e]));
+    __m128 local[3];
+    for (int column = 0; column < 3; column++) {
+        __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(&batch.axes[column * 3][e]), ox),
+                                           _mm_mul_ps(_mm_load_ps(&batch.axes[column * 3 + 1][e]), oy)),
+                                _mm_mul_ps(_mm_load_ps(&batch.axes[column * 3 + 2][e]), oz));
+        local[column] = _mm_andnot_ps(signBit, _mm_mul_ps(dot, inverse));
+    }
+    __m128 x = local[0], y = local[1], z = local[2];
+
+    __m128 m = _mm_sub_ps(_mm_add_ps(_mm_add_ps(x, y), z), one);
+    __m128 overFace = _mm_and_ps(_mm_cmpge_ps(_mm_mul_ps(three, x), m),
+                                 _mm_and_ps(_mm_cmpge_ps(_mm_mul_ps(three, y), m), _mm_cmpge_ps(_mm_mul_ps(three, z), m)));
+    __m128 hit = _mm_or_ps(_mm_cmple_ps(m, zero), _mm_and_ps(overFace, _mm_cmplt_ps(m, faceLimit)));
+
+    __m128 t = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_add_ps(_mm_sub_ps(y, x), one), half), zero), one);
+    __m128 a = _mm_add_ps(_mm_sub_ps(x, one), t);
+    __m128 b = _mm_sub_ps(y, t);
+    __m128 edgeXY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, a), _mm_mul_ps(b, b)), _mm_mul_ps(z, z));
+    t = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_add_ps(_mm_sub_ps(z, y), one), half), zero), one);
+    a = _mm_add_ps(_mm_sub_ps(y, one), t);
+    b = _mm_sub_ps(z, t);
+    __m128 edgeYZ = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(a, a)), _mm_mul_ps(b, b));
+    t = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_add_ps(_mm_sub_ps(x, z), one), half), zero), one);
+    a = _mm_add_ps(_mm_sub_ps(z, one), t);
+    b = _mm_sub_ps(x, t);
+    __m128 edgeZX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(y, y), _mm_mul_ps(a, a)), _mm_mul_ps(b, b));
+    __m128 edge = _mm_min_ps(edgeXY, _mm_min_ps(edgeYZ, edgeZX));
+    hit = _mm_or_ps(hit, _mm_cmplt_ps(edge, radiusSquare));
+    return static_cast<unsigned>(_mm_movemask_ps(hit));
+}
+
+int firstHitSSE(const glm::vec3& center, float inverseScaleSquare, float r, const OctahedronBatch& batch) {
+    __m128 cx = _mm_set1_ps(center.x), cy = _mm_set1_ps(center.y), cz = _mm_set1_ps(center.z);
+    __m128 inverse = _mm_set1_ps(inverseScaleSquare);
+    __m128 faceLimit = _mm_set1_ps(r * sqrt3);
+    __m128 radiusSquare = _mm_set1_ps(r * r);
+    for (int block = 0; block < batch.blockCount(); block++) {
+        int e = block * OctahedronBatch::blockSize;
+        unsigned mask = hitMaskSSE(batch, e, cx, cy, cz, inverse, faceLimit, radiusSquare) |
+                        hitMaskSSE(batch, e + 4, cx, cy, cz, inverse, faceLimit, radiusSquare) << 4;
+        if (mask) return e + lowestBit(mask);
+    }
+    return -1;
+}
+
+OCTAHEDRON_BATCH_AVX2
+int firstHitAVX2(const glm::vec3& center, float inverseScaleSquare, float r, const OctahedronBatch& batch) {
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 three = _mm256_set1_ps(3.0f);
+    __m256 cx = _mm256_set1_ps(center.x), cy = _mm256_set1_ps(center.y), cz = _mm256_set1_ps(center.z);
+    __m256 inverse = _mm256_set1_ps(inverseScaleSquare);
+    __m256 faceLimit = _mm256_set1_ps(r * sqrt3);
+    __m256 radiusSquare = _mm256_set1_ps(r * r);
+
+    for (int block = 0; block < batch.blockCount(); block++) {
+        int e = block * OctahedronBatch::blockSize;
+        __m256 ox = _mm256_sub_ps(cx, _mm256_load_ps(&batch.px[e]));
+        __m256 oy = _mm256_sub_ps(cy, _mm256_load_ps(&batch.py[e]));
+        __m256 oz = _mm256_sub_ps(cz, _mm256_load_ps(&batch.pz[e]));
+        __m256 local[3];
+        for (int column = 0; column < 3; column++) {
+            __m256 dot = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(&batch.axes[column * 3][e]), ox),
+                                                     _mm256_mul_ps(_mm256_load_ps(&batch.axes[column * 3 + 1][e]), oy)),
+                                       _mm256_mul_ps(_mm256_load_ps(&batch.axes[column * 3 + 2][e]), oz));
+            local[column] = _mm256_andnot_ps(signBit, _mm256_mul_ps(dot, inverse));
+        }
+        __m256 x = local[0], y = local[1], z = local[2];
+
+        __m256 m = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(x, y), z), one);
+        __m256 overFace = _mm256_and_ps(_mm256_cmp_ps(_mm256_mul_ps(three, x), m, _CMP_GE_OQ),
+                                        _mm256_and_ps(_mm256_cmp_ps(_mm256_mul_ps(three, y), m, _CMP_GE_OQ),
+                                                      _mm256_cmp_ps(_mm256_mul_ps(three, z), m, _CMP_GE_OQ)));
+        __m256 hit = _mm256_or_ps(_mm256_cmp_ps(m, zero, _CMP_LE_OQ),
+                                  _mm256_and_ps(overFace, _mm256_cmp_ps(m, faceLimit, _CMP_LT_OQ)));
+
+        __m256 t = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_sub_ps(y, x), one), half), zero), one);
+        __m256 a = _mm256_add_ps(_mm256_sub_ps(x, one), t);
+        __m256 b = _mm256_sub_ps(y, t);
+        __m256 edgeXY = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a, a), _mm256_mul_ps(b, b)), _mm256_mul_ps(z, z));
+        t = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_sub_ps(z, y), one), half), zero), one);
+        a = _mm256_add_ps(_mm256_sub_ps(y, one), t);
+        b = _mm256_sub_ps(z, t);
+        __m256 edgeYZ = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(a, a)), _mm256_mul_ps(b, b));
+        t = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_add_ps(_mm256_sub_ps(x, z), one), half), zero), one);
+        a = _mm256_add_ps(_mm256_sub_ps(z, one), t);
+        b = _mm256_sub_ps(x, t);
+        __m256 edgeZX = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(y, y), _mm256_mul_ps(a, a)), _mm256_mul_ps(b, b));
+        __m256 edge = _mm256_min_ps(edgeXY, _mm256_min_ps(edgeYZ, edgeZX));
+        hit = _mm256_or_ps(hit, _mm256_cmp_ps(edge, radiusSquare, _CMP_LT_OQ));
+
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(hit));
+        if (mask) return e + lowestBit(mask);
+    }
+    return -1;
+}
+
+bool cpuHasAVX2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    bool osSavesYmm = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6; // OSXSAVE, XMM and YMM state enabled
+    if (!osSavesYmm) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+}
+
+OctahedronKernel bestOctahedronKernel() {
+#ifdef OCTAHEDRON_BATCH_X86
+    static const OctahedronKernel best = cpuHasAVX2() ? OctahedronKernel::AVX2 : OctahedronKernel::SSE;
+    return best;
+#else
+    return OctahedronKernel::Scalar;
+#endif
+}
+
+const char* octahedronKernelName(OctahedronKernel kernel) {
+    switch (kernel) {
+    case OctahedronKernel::AVX2: return "AVX2";
+    case OctahedronKernel::SSE: return "SSE";
+    default: return "scalar";
+    }
+}
+
+int firstOctahedronHit(const glm::vec3& center, float radius, float scale, const OctahedronBatch& batch,
+                       OctahedronKernel kernel) {
+    float inverseScaleSquare = 1.0f / (scale * scale);
+    float localRadius = radius / scale;
+#ifdef OCTAHEDRON_BATCH_X86
+    if (kernel == OctahedronKernel::AVX2) return firstHitAVX2(center, inverseScaleSquare, localRadius, batch);
+    if (kernel == OctahedronKernel::SSE) return firstHitSSE(center, inverseScaleSquare, localRadius, batch);
+#endif
+    return firstHitScalar(center, inverseScaleSquare, localRadius, batch);
+}
@@ -0,0 +1,45 @@
+#ifndef OCTAHEDRONBATCH_HPP
+#define OCTAHEDRONBATCH_HPP
+
+#include <glm/glm.hpp>
+
+// Candidate obstacles of one collision query in structure-of-arrays lanes: the center and the three scaled axes
+// (first three columns of the transform) in separate float arrays. pad() fills the last block with lanes far
+// from everything, so the SIMD kernels read whole blocks of 8 without a scalar tail
+struct OctahedronBatch {
+    static const int blockSize = 8;
+    static const int capacity = 32;
+
+    alignas(32) float px[capacity];
+    alignas(32) float py[capacity];
+    alignas(32) float pz[capacity];
+    alignas(32) float axes[9][capacity]; // column c, row r of the transform at axes[c * 3 + r]
+    int index[capacity];                 // obstacle index of each lane
+    int count = 0;
+
+    void clear() { count = 0; }
+    bool isFull() const { return count == capacity; }
+    void add(const glm::mat4& transform, int obstacleIndex); // position from the fourth column
+    void pad();
+    int blockCount() const { return (count + blockSize - 1) / blockSize; }
+};
+
+enum class OctahedronKernel {
+    Scalar,
+    SSE,
+    AVX2
+};
+
+// Widest kernel this CPU runs, checked once at startup
+OctahedronKernel bestOctahedronKernel();
+const char* octahedronKernelName(OctahedronKernel kernel);
+
+// Exact signed distance from p to the unit octahedron |x| + |y| + |z| <= 1, negative inside
+float unitOctahedronDistance(const glm::vec3& p);
+
+// First lane (in order) whose octahedron - the unit one under the lane's transform, scaled by scale - a sphere
+// overlaps, -1 when none does. A sphere inside an obstacle overlaps it. The batch has to be padded
+int firstOctahedronHit(const glm::vec3& center, float radius, float scale, const OctahedronBatch& batch,
+                       OctahedronKernel kernel = bestOctahedronKernel());
+
+#endif
@@ -3,6 +3,7 @@
 #include "ObstacleManager.hpp"
 #include "shader_utils.h"
 #include "MiniMap.hpp"
+#include <algorithm>
 #include <iostream>
 #include <glm/gtc/matrix_transform.hpp> 
 #define STB_IMAGE_IMPLEMENTATION
@@ -14,10 +15,12 @@
 Renderer::Renderer() 
     : obstacleShader(0), wallShader(0), sphereShader(0), wireframeShader(0), 
       obstacleVAO(0), obstacleVBO(0), obstacleEBO(0),
+      obstacleDataTexture(0), obstaclesPerRow(1), allObstaclesVBO(0), visibleObstaclesVBO(0),
       cubeVAO(0), cubeVBO(0), cubeEBO(0),
       sphereVAO(0), sphereVBO(0), sphereEBO(0),
       wireframeVAO(0), wireframeVBO(0), wireframeEBO(0),
       wallTexture(0),
+      obstacleInstanceCount(0), visibleObstacleCount(0), visibleObstacleCapacity(0), obstacleRadius(0.0f), obstacleTime(0.0f),
       viewportX(0), viewportY(0), viewportWidth(1200), viewportHeight(900) {
 }
 
@@ -26,7 +29,7 @@ Renderer::~Renderer() {
 }
 
 bool Renderer::initialize() {
-    obstacleShader = createShaderProgram("../shaders/basic_vert.glsl", "../shaders/obstacle_dots_frag.glsl");
+    obstacleShader = createShaderProgram("../shaders/obstacle_instanced_vert.glsl", "../shaders/obstacle_dots_frag.glsl");
     wallShader = createShaderProgram("../shaders/basic_vert.glsl", "../shaders/wall_frag.glsl");
     sphereShader = createShaderProgram("../shaders/basic_vert.glsl", "../shaders/sphere_frag.glsl");
     wireframeShader = createShaderProgram("../shaders/basic_vert.glsl", "../shaders/wireframe_frag.glsl");
@@ -82,6 +85,9 @@ void Renderer::cleanup() {
     if (obstacleVAO) glDeleteVertexArrays(1, &obstacleVAO);
     if (obstacleVBO) glDeleteBuffers(1, &obstacleVBO);
     if (obstacleEBO) glDeleteBuffers(1, &obstacleEBO);
+    if (obstacleDataTexture) glDeleteTextures(1, &obstacleDataTexture);
+    if (allObstaclesVBO) glDeleteBuffers(1, &allObstaclesVBO);
+    if (visibleObstaclesVBO) glDeleteBuffers(1, &visibleObstaclesVBO);
     
     if (cubeVAO) glDeleteVertexArrays(1, &cubeVAO);
     if (cubeVBO) glDeleteBuffers(1, &cubeVBO);
@@ -117,7 +123,6 @@ void Renderer::setViewport(int x, int y, int width, int height) {
 }
 
 void Renderer::renderMiniMap(const MiniMap& miniMap,
-                            const std::vector<Obstacle>& obstacles,
                             const std::vector<Coin>& coins,
                             const glm::vec3& playerPosition, float playerRadius) {
     
@@ -140,19 +145,8 @@ void Renderer::renderMiniMap(const MiniMap& miniMap,
     // Render wireframe cube
     renderCubeWireframe(view, projection);
     
-    // Render obstacles in minimap 
-    glUseProgram(obstacleShader);
-    glUniformMatrix4fv(glGetUniformLocation(obstacleShader, "view"), 1, GL_FALSE, &view[0][0]);
-    glUniformMatrix4fv(glGetUniformLocation(obstacleShader, "projection"), 1, GL_FALSE, &projection[0][0]);
-    
-    glBindVertexArray(obstacleVAO);
-    for (const auto& obstacle : obstacles) {
-        glUniformMatrix4fv(glGetUniformLocation(obstacleShader, "model"), 1, GL_FALSE, &obstacle.transform[0][0]);
-        glUniform3f(glGetUniformLocation(obstacleShader, "objectColor"), 
-                   obstacle.color.r, obstacle.color.g, obstacle.color.b);
-        glDrawElements(GL_TRIANGLES, obstacleIndexCount, GL_UNSIGNED_INT, 0);
-    }
-    glBindVertexArray(0);
+    // Render obstacles in minimap from the instances the main view already uploaded
+    drawObstacleInstances(allObstaclesVBO, obstacleInstanceCount, view, projection);
     
     // Render player in minimap
     glm::mat4 playerModel = glm::mat4(1.0f);
@@ -220,24 +214,86 @@ void Renderer::clear() {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
-void Renderer::renderObstacles(const std::vector<Obstacle>& obstacles, 
-                              const glm::mat4& view, const glm::mat4& projection) {
+void Renderer::setObstacleInstances(const std::vector<Obstacle>& obstacles, float obstacleRadius) {
+    std::vector<ObstacleInstance> instances(obstacles.size());
+    std::vector<unsigned int> all(obstacles.size());
+    for (size_t i = 0; i < obstacles.size(); i++) {
+        instances[i].positionSpeed = glm::vec4(obstacles[i].position, obstacles[i].rotationSpeed);
+        instances[i].rotationAxis = glm::vec4(obstacles[i].rotationAxis, 0.0f);
+        instances[i].color = glm::vec4(obstacles[i].color, 1.0f);
+        all[i] = static_cast<unsigned int>(i);
+    }
+    obstacleInstanceCount = instances.size();
+    visibleObstacleCount = 0;
+    this->obstacleRadius = obstacleRadius;
+
+    // as wide as the texture size allows, so large levels take few bands
+    GLint maxTextureSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+    obstaclesPerRow = static_cast<int>(std::max<size_t>(1, std::min<size_t>(maxTextureSize, instances.size())));
+    int bands = static_cast<int>((instances.size() + obstaclesPerRow - 1) / obstaclesPerRow);
+    if (bands * 3 > maxTextureSize) {
+        std::cerr << "Too many obstacles for the obstacle data texture: " << instances.size() << std::endl;
+        bands = maxTextureSize / 3;
+    }
+    std::vector<glm::vec4> texels(static_cast<size_t>(obstaclesPerRow) * std::max(1, bands) * 3, glm::vec4(0.0f));
+    for (size_t i = 0; i < instances.size() && static_cast<int>(i / obstaclesPerRow) < bands; i++) {
+        size_t first = (i / obstaclesPerRow) * 3 * obstaclesPerRow + i % obstaclesPerRow;
+        texels[first] = instances[i].positionSpeed;
+        texels[first + obstaclesPerRow] = instances[i].rotationAxis;
+        texels[first + 2 * obstaclesPerRow] = instances[i].color;
+    }
+    glBindTexture(GL_TEXTURE_2D, obstacleDataTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, obstaclesPerRow, std::max(1, bands) * 3, 0, GL_RGBA, GL_FLOAT,
+                 texels.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, allObstaclesVBO);
+    glBufferData(GL_ARRAY_BUFFER, all.size() * sizeof(unsigned int), all.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Renderer::setVisibleObstacles(const std::vector<unsigned int>& visible) {
+    visibleObstacleCount = visible.size();
+    glBindBuffer(GL_ARRAY_BUFFER, visibleObstaclesVBO);
+    if (visible.size() > visibleObstacleCapacity) {
+        visibleObstacleCapacity = visible.size();
+        glBufferData(GL_ARRAY_BUFFER, visible.size() * sizeof(unsigned int), visible.data(), GL_STREAM_DRAW);
+    } else {
+        // Orphan the old storage so the driver does not wait for last frame's draw to finish reading it
+        glBufferData(GL_ARRAY_BUFFER, visibleObstacleCapacity * sizeof(unsigned int), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, visible.size() * sizeof(unsigned int), visible.data());
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void Renderer::drawObstacleInstances(GLuint indexBuffer, size_t count, const glm::mat4& view, const glm::mat4& projection) {
+    if (count == 0) return;
+
     glUseProgram(obstacleShader);
-    
     glUniformMatrix4fv(glGetUniformLocation(obstacleShader, "view"), 1, GL_FALSE, &view[0][0]);
     glUniformMatrix4fv(glGetUniformLocation(obstacleShader, "projection"), 1, GL_FALSE, &projection[0][0]);
-    
+    glUniform1f(glGetUniformLocation(obstacleShader, "time"), obstacleTime);
+    glUniform1f(glGetUniformLocation(obstacleShader, "obstacleRadius"), obstacleRadius);
+    glUniform1i(glGetUniformLocation(obstacleShader, "obstacleData"), 0);
+    glUniform1i(glGetUniformLocation(obstacleShader, "obstaclesPerRow"), obstaclesPerRow);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, obstacleDataTexture);
+
+    // the instances' obstacle indices come from whichever list this pass draws
     glBindVertexArray(obstacleVAO);
-    
-    for (const auto& obstacle : obstacles) {
-        glUniformMatrix4fv(glGetUniformLocation(obstacleShader, "model"), 1, GL_FALSE, &obstacle.transform[0][0]);
-        glUniform3f(glGetUniformLocation(obstacleShader, "objectColor"), 
-                   obstacle.color.r, obstacle.color.g, obstacle.color.b);
-        
-        glDrawElements(GL_TRIANGLES, obstacleIndexCount, GL_UNSIGNED_INT, 0);
-    }
-    
+    glBindBuffer(GL_ARRAY_BUFFER, indexBuffer);
+    glVertexAttribIPointer(3, 1, GL_UNSIGNED_INT, sizeof(unsigned int), (void*)0);
+    glDrawElementsInstanced(GL_TRIANGLES, obstacleIndexCount, GL_UNSIGNED_INT, 0, static_cast<GLsizei>(count));
     glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Renderer::renderObstacles(const glm::mat4& view, const glm::mat4& projection) {
+    drawObstacleInstances(visibleObstaclesVBO, visibleObstacleCount, view, projection);
 }
 
 void Renderer::renderCubeWalls(const glm::mat4& view, const glm::mat4& projection) {
@@ -322,6 +378,22 @@ void Renderer::setupObstacleMesh() {
     Mesh octahedron = MeshGenerator::generateOctahedron();
     setupMeshBuffers(octahedron, obstacleVAO, obstacleVBO, obstacleEBO);
     obstacleIndexCount = octahedron.indices.size();
+
+    // Obstacle data as a 2D texture of RGBA floats, three texels per obstacle, read with texelFetch only;
+    // without mipmaps the minifying filter must not use them or the texture is incomplete
+    glGenTextures(1, &obstacleDataTexture);
+    glBindTexture(GL_TEXTURE_2D, obstacleDataTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Instance attribute 3: the obstacle's index, from the list of all obstacles or of the visible ones
+    glGenBuffers(1, &allObstaclesVBO);
+    glGenBuffers(1, &visibleObstaclesVBO);
+    glBindVertexArray(obstacleVAO);
+    glEnableVertexAttribArray(3);
+    glVertexAttribDivisor(3, 1);
+    glBindVertexArray(0);
 }
 
 void Renderer::setupCubeMesh() {
@@ -336,7 +408,8 @@ void Renderer::setupSphereMesh() {
     sphereIndexCount = sphere.indices.size();
 }
 
-void Renderer::renderCoins(const std::vector<Coin>& coins, const glm::mat4& view, const glm::mat4& projection) {
+void Renderer::renderCoins(const std::vector<Coin>& coins, const std::vector<unsigned int>& visible,
+                           const glm::mat4& view, const glm::mat4& projection) {
     glUseProgram(coinShader);
     
     glUniformMatrix4fv(glGetUniformLocation(coinShader, "view"), 1, GL_FALSE, &view[0][0]);
@@ -344,17 +417,17 @@ void Renderer::renderCoins(const std::vector<Coin>& coins, const glm::mat4& view
     
     glBindVertexArray(coinVAO);
     
-    for (const auto& coin : coins) {
-        if (!coin.collected) {
-            glm::mat4 model = glm::mat4(1.0f);
-            model = glm::translate(model, coin.position);
-            model = glm::scale(model, glm::vec3(coin.radius));
-            
-            glUniformMatrix4fv(glGetUniformLocation(coinShader, "model"), 1, GL_FALSE, &model[0][0]);
-            glUniform3f(glGetUniformLocation(coinShader, "objectColor"), 1.0f, 1.0f, 0.0f); // Yellow
-            
-            glDrawElements(GL_TRIANGLES, coinIndexCount, GL_UNSIGNED_INT, 0);
-        }
+    // only the coins left to collect that the frustum reaches
+    for (unsigned int index : visible) {
+        const Coin& coin = coins[index];
+        glm::mat4 model = glm::mat4(1.0f);
+        model = glm::translate(model, coin.position);
+        model = glm::scale(model, glm::vec3(coin.radius));
+        
+        glUniformMatrix4fv(glGetUniformLocation(coinShader, "model"), 1, GL_FALSE, &model[0][0]);
+        glUniform3f(glGetUniformLocation(coinShader, "objectColor"), 1.0f, 1.0f, 0.0f); // Yellow
+        
+        glDrawElements(GL_TRIANGLES, coinIndexCount, GL_UNSIGNED_INT, 0);
     }
     
     glBindVertexArray(0);
@@ -10,6 +10,15 @@ struct Mesh;
 struct Obstacle;
 class MiniMap;
 
+// Static data of one obstacle, three texels of the obstacle data texture fixed for the level:
+// obstacle_instanced_vert.glsl fetches it by the instance's obstacle index and rebuilds the model matrix from it
+// and the time uniform the way ObstacleManager::obstacleTransform does
+struct ObstacleInstance {
+    glm::vec4 positionSpeed; // position, rotation speed
+    glm::vec4 rotationAxis;  // w unused
+    glm::vec4 color;         // w unused
+};
+
 class Renderer {
     public:
     Renderer();
@@ -21,17 +30,22 @@ class Renderer {
     void setViewport(int x, int y, int width, int height);
     void clear();
     
-    void renderObstacles(const std::vector<Obstacle>& obstacles, 
-                         const glm::mat4& view, const glm::mat4& projection);
+    // Uploads the obstacles' static data once per level, renderObstacles and renderMiniMap both draw from it.
+    // Per frame only the time and the visible obstacles' indices change
+    void setObstacleInstances(const std::vector<Obstacle>& obstacles, float obstacleRadius);
+    void setObstacleTime(float time) { obstacleTime = time; }
+    // Obstacles the first-person view draws, from FrustumCuller. The minimap draws all of them
+    void setVisibleObstacles(const std::vector<unsigned int>& visible);
+    void renderObstacles(const glm::mat4& view, const glm::mat4& projection);
     void renderCubeWalls(const glm::mat4& view, const glm::mat4& projection);
     void renderPlayerSphere(const glm::vec3& position, float radius,
                             const glm::mat4& view, const glm::mat4& projection);
     void renderMiniMap(const MiniMap& miniMap,
-                       const std::vector<Obstacle>& obstacles,
                        const std::vector<Coin>& coins,
                        const glm::vec3& playerPosition, float playerRadius);
     void renderCubeWireframe(const glm::mat4& view, const glm::mat4& projection);    
-    void renderCoins(const std::vector<Coin>& coins, const glm::mat4& view, const glm::mat4& projection);
+    void renderCoins(const std::vector<Coin>& coins, const std::vector<unsigned int>& visible,
+                     const glm::mat4& view, const glm::mat4& projection);
 
 
     void setupObstacleMesh();
@@ -51,6 +65,12 @@ private:
     
     
     GLuint obstacleVAO, obstacleVBO, obstacleEBO;
+    // ObstacleInstance per obstacle in a 2D RGBA float texture (a texture buffer need only hold 65536 texels in
+    // GL 3.3): obstacle i sits in column i % obstaclesPerRow, its three texels in consecutive rows of band
+    // i / obstaclesPerRow
+    GLuint obstacleDataTexture;
+    int obstaclesPerRow;
+    GLuint allObstaclesVBO, visibleObstaclesVBO;     // obstacle index per instance
     GLuint cubeVAO, cubeVBO, cubeEBO;
     GLuint sphereVAO, sphereVBO, sphereEBO;
     GLuint wireframeVAO, wireframeVBO, wireframeEBO;
@@ -61,11 +81,18 @@ private:
     unsigned int sphereIndexCount;
     unsigned int wireframeIndexCount;
     unsigned int coinIndexCount;
+
+    size_t obstacleInstanceCount;
+    size_t visibleObstacleCount;
+    size_t visibleObstacleCapacity; // indices the visible buffer holds
+    float obstacleRadius;
+    float obstacleTime;
     
     int viewportX, viewportY, viewportWidth, viewportHeight;
     
     GLuint createShaderProgram(const char* vertexPath, const char* fragmentPath);
     void setupMeshBuffers(const Mesh& mesh, GLuint& VAO, GLuint& VBO, GLuint& EBO);
+    void drawObstacleInstances(GLuint indexBuffer, size_t count, const glm::mat4& view, const glm::mat4& projection);
 };
 
 #endif
\ No newline at end of file
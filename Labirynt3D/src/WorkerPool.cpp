@@ -0,0 +1,53 @@
+#include "WorkerPool.hpp"
+#include <algorithm>
+
+WorkerPool::WorkerPool(unsigned int threadCount)
+    : threadCount(threadCount ? threadCount : std::max(1u, std::thread::hardware_concurrency())),
+      job(nullptr), generation(0), busy(0), quitting(false) {
+    for (unsigned int t = 1; t < this->threadCount; t++) {
+        threads.emplace_back([this, t]() { loop(t); });
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quitting = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads) thread.join();
+}
+
+void WorkerPool::run(const std::function<void(unsigned int)>& job) {
+    if (threads.empty()) {
+        job(0);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->job = &job;
+        busy = static_cast<unsigned int>(threads.size());
+        generation++;
+    }
+    wake.notify_all();
+    job(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this]() { return busy == 0; });
+    this->job = nullptr;
+}
+
+void WorkerPool::loop(unsigned int t) {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [&]() { return quitting || generation != seen; });
+        if (quitting) return;
+        seen = generation;
+        const std::function<void(unsigned int)>& current = *job;
+        lock.unlock();
+        current(t);
+        lock.lock();
+        if (--busy == 0) finished.notify_one();
+    }
+}
@@ -6,6 +6,7 @@
 #include <string>
 #include <ctime>
 #include <cstdlib>
+#include <cstdio>
 
 #include "Camera.hpp"
 #include "Player.hpp"
@@ -15,6 +16,8 @@
 #include "Collision.hpp"
 #include "MiniMap.hpp"
 #include "CoinManager.hpp"
+#include "FrustumCuller.hpp"
+#include "OcclusionCuller.hpp"
 #include "shader_utils.h"
 
 
@@ -27,6 +30,8 @@ Renderer renderer;
 InputHandler inputHandler;
 MiniMap miniMap;
 CoinManager coinManager;
+FrustumCuller frustumCuller;
+OcclusionCuller occlusionCuller;
 int score = 0;
 
 // Window dimensions
@@ -41,6 +46,11 @@ float gameEndTime = 0.0f;
 bool gameWon = false;
 float winAnimationProgress = 0.0f;
 
+// Frame rate and culling stats, shown in the window title once a second
+float statsStartTime = 0.0f;
+int statsFrames = 0;
+void updateStatsTitle(float currentFrame);
+
 //win Animation
 GLuint winShader;
 GLuint winVAO, winVBO;
@@ -90,6 +100,8 @@ int main(int argc, char* argv[]) {
     }
     
     obstacleManager.generateObstacles(gridSize, seed);
+    renderer.setObstacleInstances(obstacleManager.getObstacles(), obstacleManager.getObstacleRadius());
+    frustumCuller.build(obstacleManager);
     setupWinAnimation();
     
     std::vector<glm::vec3> obstaclePositions;
@@ -117,6 +129,7 @@ int main(int argc, char* argv[]) {
         miniMap.update(deltaTime);
         
         obstacleManager.updateObstacles(deltaTime);
+        renderer.setObstacleTime(obstacleManager.getTime());
 
         coinManager.checkPlayerCollision(player.getPosition(), player.getRadius(), score);
 
@@ -136,17 +149,19 @@ int main(int argc, char* argv[]) {
             float aspectRatio = (windowWidth > windowHeight) ? 
             (float)windowHeight / (float)windowWidth : 1.0f;
             glm::mat4 projection = camera.getProjectionMatrix(aspectRatio);
+            frustumCuller.cull(projection * view, coinManager.getCoins());
+            occlusionCuller.cull(projection * view, camera.getPosition(), obstacleManager, frustumCuller);
+            renderer.setVisibleObstacles(occlusionCuller.getVisibleObstacles());
             
             // Render for fps view
             renderer.renderCubeWalls(view, projection);
-            renderer.renderObstacles(obstacleManager.getObstacles(), view, projection);
+            renderer.renderObstacles(view, projection);
             renderWinAnimation(winAnimationProgress);
             
-            renderer.renderCoins(coinManager.getCoins(), view, projection);
+            renderer.renderCoins(coinManager.getCoins(), frustumCuller.getVisibleCoins(), view, projection);
             
             // Render minimap 
-            renderer.renderMiniMap(miniMap, obstacleManager.getObstacles(), 
-                                coinManager.getCoins(),
+            renderer.renderMiniMap(miniMap, coinManager.getCoins(),
                                 player.getPosition(), player.getRadius());
         }
         else {
@@ -155,16 +170,18 @@ int main(int argc, char* argv[]) {
             float aspectRatio = (windowWidth > windowHeight) ? 
                             (float)windowHeight / (float)windowWidth : 1.0f;
             glm::mat4 projection = camera.getProjectionMatrix(aspectRatio);
+            frustumCuller.cull(projection * view, coinManager.getCoins());
+            occlusionCuller.cull(projection * view, camera.getPosition(), obstacleManager, frustumCuller);
+            renderer.setVisibleObstacles(occlusionCuller.getVisibleObstacles());
             
             // Render for fps view
             renderer.renderCubeWalls(view, projection);
-            renderer.renderObstacles(obstacleManager.getObstacles(), view, projection);
+            renderer.renderObstacles(view, projection);
             
-            renderer.renderCoins(coinManager.getCoins(), view, projection);
+            renderer.renderCoins(coinManager.getCoins(), frustumCuller.getVisibleCoins(), view, projection);
             
             // Render minimap 
-            renderer.renderMiniMap(miniMap, obstacleManager.getObstacles(), 
-                                coinManager.getCoins(),
+            renderer.renderMiniMap(miniMap, coinManager.getCoins(),
                                 player.getPosition(), player.getRadius());
 
             if (player.checkGoalReached() && !player.hasReachedGoal() && score==10) {
@@ -174,6 +191,8 @@ int main(int argc, char* argv[]) {
             }
         }
 
+        updateStatsTitle(currentFrame);
+
         // End input frame (update previous key states)
         inputHandler.endFrame();
         glfwSwapBuffers(window);
@@ -245,14 +264,8 @@ void processInput(GLFWwindow* window) {
     glm::vec3 clampedPosition = newPosition;
     Collision::checkWorldBoundaries(newPosition, player.getRadius(), clampedPosition);
     
-    // Check collisions with obstacles
-    bool collision = false;
-    for (const auto& obstacle : obstacleManager.getObstacles()) {
-        if (Collision::checkSphereObstacleCollision(clampedPosition, player.getRadius(), obstacle)) {
-            collision = true;
-            break;
-        }
-    }
+    // Check collisions with the obstacles on the lattice points around the player
+    bool collision = Collision::checkSphereLatticeCollision(clampedPosition, player.getRadius(), obstacleManager);
     
     // Update player position if no collision
     if (!collision) {
@@ -262,6 +275,23 @@ void processInput(GLFWwindow* window) {
     }
 }
 
+void updateStatsTitle(float currentFrame) {
+    statsFrames++;
+    if (currentFrame - statsStartTime < 1.0f) return;
+    const CullingStats& stats = frustumCuller.getStats();
+    const OcclusionStats& occlusion = occlusionCuller.getStats();
+    char occlusionTime[32];
+    std::snprintf(occlusionTime, sizeof(occlusionTime), "%.2f + %.2f ms", occlusion.rasterizeMs, occlusion.testMs);
+    std::string title = "3D Maze Game - " + std::to_string(static_cast<int>(statsFrames / (currentFrame - statsStartTime))) +
+                        " FPS, obstacles " + std::to_string(stats.obstaclesVisible - occlusion.culled) + " drawn / " +
+                        std::to_string(stats.obstaclesCulled) + " culled, " + std::to_string(occlusion.culled) +
+                        " occluded (" + std::to_string(occlusion.occluders) + " occluders, " + occlusionTime + "), " +
+                        std::to_string(stats.nodesVisited) + " nodes, coins " + std::to_string(stats.coinsCulled) + " culled";
+    glfwSetWindowTitle(window, title.c_str());
+    statsStartTime = currentFrame;
+    statsFrames = 0;
+}
+
 void updateViewport() {
     // Calculate centered square viewport
     int size = std::min(windowWidth, windowHeight);
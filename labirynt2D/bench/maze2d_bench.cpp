@@ -0,0 +1,583 @@
+// Headless benchmark of maze2d_core: generation time, collision query cost and obstacle memory
+// across GRID_N sizes and seeds, the neighbor cache on a recorded walk and the signed distance field of the glow
+// (bake time and memory). First checks that generation gives the same layout for a seed whatever the thread count
+// and that the SIMD segment kernels match the scalar reference, and ends with the flow field builder (its verdicts
+// checked against a finer search), the multi-agent stress mode and the fixed-rate simulation thread.
+// Usage: maze2d_bench [--large] [queries] [seedCount] [skin]
+// --large adds the stored GRID_N 5000 case, about 1.1 GB of obstacles
+#include <glm/glm.hpp>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include "Maze.hpp"
+#include "Player.hpp"
+#include "AgentSwarm.hpp"
+#include "FlowField.hpp"
+#include "SegmentBatch.hpp"
+#include "Geometry2D.hpp"
+#include "Simulation.hpp"
+#include "ConvexCollision.hpp"
+
+using namespace glm;
+
+struct Pose {
+    float x, y, angle;
+};
+
+struct Motion {
+    Pose from, to;
+};
+
+struct BenchCase {
+    int gridN;
+    bool implicit;
+};
+
+// FNV-1a over the bits of every obstacle instance (center and angle)
+static uint64_t layoutHash(const Maze& maze) {
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (const ObstacleInstance& instance : maze.getInstances()) {
+        float values[3] = { instance.center.x, instance.center.y, instance.angle };
+        unsigned char bytes[sizeof(values)];
+        std::memcpy(bytes, values, sizeof(values));
+        for (unsigned char byte : bytes) {
+            hash = (hash ^ byte) * 0x100000001B3ull;
+        }
+    }
+    return hash;
+}
+
+// Generates each size on 1..8 threads and compares the layout hashes, returns false on any difference
+static bool checkDeterminism(unsigned int seed) {
+    bool same = true;
+    Maze maze;
+    for (int gridN : { 10, 300, 2000 }) {
+        uint64_t reference = 0;
+        std::cout << "GRID_N " << std::setw(5) << gridN << " seed " << seed << ":";
+        for (unsigned int threads : { 1u, 2u, 3u, 8u }) {
+            auto start = std::chrono::high_resolution_clock::now();
+            maze.generate(gridN, seed, threads);
+            auto end = std::chrono::high_resolution_clock::now();
+            uint64_t hash = layoutHash(maze);
+            if (threads == 1) reference = hash;
+            std::cout << "  " << threads << " thr " << std::fixed << std::setprecision(1)
+                      << std::chrono::duration<double, std::milli>(end - start).count() << " ms";
+            same = same && (hash == reference);
+        }
+
+        // the implicit layout draws the same rotations
+        Maze implicitMaze;
+        implicitMaze.generateImplicit(gridN, seed);
+        for (int k = 0; k < 100; k++) {
+            int i = (k * 7) % gridN, j = (k * 13 + 1) % gridN;
+            if (!maze.getGrid().isEmptyCell(i, j)) same = same && (maze.obstacleAngle(i, j) == implicitMaze.obstacleAngle(i, j));
+        }
+        std::cout << "  hash " << std::hex << reference << std::dec << "\n";
+    }
+    return same;
+}
+
+// Differential test of every segment kernel the CPU runs against segmentsCross on random rhombus outlines,
+// with shared endpoints and collinear edges mixed in, then their throughput. Returns false on any mismatch
+static bool checkSegmentKernels(unsigned int seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> coord(-1.0f, 1.0f);
+    std::vector<Rhombus> outlines(64);
+    EdgeBatch edges;
+    for (Rhombus& poly : outlines) {
+        glm::vec2 center(coord(rng), coord(rng));
+        for (glm::vec2& vertex : poly) vertex = center + glm::vec2(coord(rng), coord(rng)) * 0.2f;
+        edges.addPolygon(poly.data(), 4);
+    }
+
+    std::vector<SegmentKernel> kernels = { SegmentKernel::Scalar };
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    kernels.push_back(SegmentKernel::SSE);
+    if (bestSegmentKernel() == SegmentKernel::AVX2) kernels.push_back(SegmentKernel::AVX2);
+#endif
+
+    const int segmentCount = 20000;
+    std::vector<glm::vec2> segments(segmentCount * 2);
+    for (int i = 0; i < segmentCount; i++) {
+        glm::vec2 p1(coord(rng), coord(rng)), p2(coord(rng), coord(rng));
+        const Rhombus& poly = outlines[i % outlines.size()];
+        if (i % 4 == 1) p1 = poly[0];                             // touches an obstacle vertex
+        if (i % 4 == 2) p2 = poly[1] + (poly[1] - poly[0]) * 0.5f; // collinear with an obstacle edge
+        segments[i * 2] = p1;
+        segments[i * 2 + 1] = p2;
+    }
+
+    bool same = true;
+    std::vector<uint8_t> masks(edges.blockCount());
+    std::cout << "segment kernels, " << edges.count << " edges:";
+    for (SegmentKernel kernel : kernels) {
+        size_t mismatches = 0;
+        for (int i = 0; i < segmentCount; i++) {
+            glm::vec2 p1 = segments[i * 2], p2 = segments[i * 2 + 1];
+            segmentCrossings(p1, p2, edges, masks.data(), kernel);
+            for (size_t e = 0; e < edges.count; e++) {
+                glm::vec2 q1(edges.ax[e], edges.ay[e]);
+                glm::vec2 q2 = outlines[e / 4][(e + 1) % 4];
+                bool expected = segmentsCross(p1, p2, q1, q2);
+                bool got = (masks[e / EdgeBatch::blockSize] >> (e % EdgeBatch::blockSize)) & 1;
+                mismatches += expected != got;
+            }
+        }
+
+        const int rounds = 20;
+        int crossing = 0;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int r = 0; r < rounds; r++) {
+            for (int i = 0; i < segmentCount; i++) {
+                crossing += segmentCrossings(segments[i * 2], segments[i * 2 + 1], edges, masks.data(), kernel);
+            }
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() / (double(rounds) * segmentCount);
+        std::cout << "  " << segmentKernelName(kernel) << " " << std::fixed << std::setprecision(1) << ns
+                  << " ns/segment (" << crossing / rounds << " crossing, " << mismatches << " mismatches)";
+        same = same && mismatches == 0;
+    }
+
+    // the division-free form only differs from segmentsIntersect in rounding right at the segment ends
+    size_t rounding = 0;
+    for (int i = 0; i < segmentCount; i++) {
+        for (size_t e = 0; e < edges.count; e++) {
+            glm::vec2 q1(edges.ax[e], edges.ay[e]);
+            glm::vec2 q2 = outlines[e / 4][(e + 1) % 4];
+            rounding += segmentsCross(segments[i * 2], segments[i * 2 + 1], q1, q2) !=
+                        segmentsIntersect(segments[i * 2], segments[i * 2 + 1], q1, q2);
+        }
+    }
+    std::cout << "  best " << segmentKernelName(bestSegmentKernel()) << ", " << rounding
+              << " rounding differences to segmentsIntersect\n";
+    return same;
+}
+
+// Reference planner for the flow field's verdict: breadth-first search over poses sampled twice as finely in
+// position and angle, with diagonal moves, each move or turn also checked at its midpoint. Starts from the
+// player's start pose and stops at the first pose on the finish corner
+static bool referenceSolvable(const Maze& maze, int subdivisions, int angleCount) {
+    const float pi = 3.14159265358979323846f;
+    const int side = (maze.getGridN() - 1) * subdivisions + 1;
+    const float spacing = maze.getStep() / subdivisions;
+    const glm::vec2 origin = maze.getGrid().cellCenter(0, 0);
+    const float turn = pi / angleCount;
+    auto collides = [&](float u, float v, float a) {
+        return maze.playerCollides(origin.x + u * spacing, origin.y + v * spacing, a * turn);
+    };
+
+    // 0 - not tested yet, 1 - free, 2 - blocked, 3 - reached
+    std::vector<uint8_t> states(static_cast<size_t>(side) * side * angleCount, 0);
+    auto state = [&](int u, int v, int a) -> uint8_t& { return states[(static_cast<size_t>(v) * side + u) * angleCount + a]; };
+    auto isFree = [&](int u, int v, int a) {
+        uint8_t& s = state(u, v, a);
+        if (s == 0) s = collides(float(u), float(v), float(a)) ? 2 : 1;
+        return s != 2;
+    };
+
+    Player player;
+    float startAngle = std::fmod(player.getAngle(), pi);
+    if (startAngle < 0.0f) startAngle += pi;
+    int startA = static_cast<int>(std::lround(startAngle / turn)) % angleCount;
+    if (!isFree(0, 0, startA)) return false;
+    std::vector<int> queue;
+    queue.push_back(startA);
+    state(0, 0, startA) = 3;
+    const int du[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+    const int dv[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+    for (size_t head = 0; head < queue.size(); head++) {
+        int a = queue[head] % angleCount, p = queue[head] / angleCount;
+        int u = p % side, v = p / side;
+        if (u == side - 1 && v == side - 1) return true;
+        auto visit = [&](int nu, int nv, int na, float midU, float midV, float midA) {
+            if (!isFree(nu, nv, na) || state(nu, nv, na) == 3 || collides(midU, midV, midA)) return;
+            state(nu, nv, na) = 3;
+            queue.push_back((nv * side + nu) * angleCount + na);
+        };
+        for (int d = 0; d < 8; d++) {
+            int nu = u + du[d], nv = v + dv[d];
+            if (nu < 0 || nv < 0 || nu >= side || nv >= side) continue;
+            visit(nu, nv, a, u + du[d] * 0.5f, v + dv[d] * 0.5f, float(a));
+        }
+        visit(u, v, (a + 1) % angleCount, float(u), float(v), a + 0.5f);
+        visit(u, v, (a + angleCount - 1) % angleCount, float(u), float(v), a - 0.5f);
+    }
+    return false;
+}
+
+// Compares the flow field's verdict with the finer reference planner on small levels, and on the most cluttered
+// of the first few hundred GRID_N 10 levels (the one with the most pieces of free poses in a room). Returns false
+// when the field calls a level unsolvable that the reference gets through
+static bool checkFlowVerdicts(int seedCount) {
+    bool agrees = true;
+    Maze maze;
+    FlowField flow;
+    auto compare = [&](int gridN, unsigned int seed) {
+        maze.generate(gridN, seed);
+        flow.build(maze);
+        bool reference = referenceSolvable(maze, FlowField::subdivisions * 2, FlowField::angleCount * 2);
+        std::cout << "  seed " << seed << " " << (flow.isSolvable() ? "yes" : "no") << "/"
+                  << (reference ? "yes" : "no");
+        agrees = agrees && (flow.isSolvable() || !reference);
+    };
+    for (int gridN : { 10, 20 }) {
+        std::cout << "flow verdicts GRID_N " << std::setw(3) << gridN << ":";
+        for (int s = 0; s < seedCount; s++) compare(gridN, 1 + s * 7919);
+        std::cout << "\n";
+    }
+
+    unsigned int clutteredSeed = 1;
+    int mostPieces = 0;
+    for (unsigned int seed = 1; seed <= 500; seed++) {
+        maze.generate(10, seed);
+        flow.build(maze);
+        if (flow.getMostPieces() > mostPieces) {
+            mostPieces = flow.getMostPieces();
+            clutteredSeed = seed;
+        }
+    }
+    std::cout << "flow verdicts GRID_N  10, " << mostPieces << " pieces in one room:";
+    compare(10, clutteredSeed);
+    std::cout << "\n";
+    return agrees;
+}
+
+// Ticks a swarm of agentCount agents for about a second and prints agent-steps per second
+static void runSwarm(const Maze& maze, int agentCount, unsigned int seed) {
+    AgentSwarm swarm;
+    swarm.spawn(maze, agentCount, seed);
+
+    const float dt = 1.0f / 60.0f;
+    int ticks = 0;
+    double seconds = 0.0;
+    while (seconds < 1.0 || ticks < 3) {
+        auto start = std::chrono::high_resolution_clock::now();
+        swarm.tick(maze, ticks * dt);
+        auto end = std::chrono::high_resolution_clock::now();
+        seconds += std::chrono::duration<double>(end - start).count();
+        ticks++;
+    }
+
+    std::cout << std::setw(10) << maze.getGridN() << std::setw(10) << agentCount << std::setw(8) << ticks
+              << std::fixed << std::setprecision(1)
+              << std::setw(12) << seconds * 1000.0 / ticks
+              << std::setw(14) << swarm.getSteps() / seconds / 1e6
+              << std::setw(10) << swarm.getArrivals() << "\n";
+}
+
+// Exact SAT pose queries against the occupancy raster on the same random poses: bake cost, memory, queries per
+// second and the widest gap (in texels) between the player and the obstacles wherever the two disagree.
+// Returns false when the raster misses an overlap or reports one across more than a texel diagonal
+static bool runOccupancy(int gridN, int queries) {
+    Maze maze;
+    maze.generate(gridN, 1);
+    std::mt19937 rng(gridN);
+    std::uniform_real_distribution<float> coord(-0.9f, 0.9f), turn(0.0f, 6.2831853f);
+    std::vector<Pose> poses(queries);
+    for (Pose& pose : poses) pose = Pose{ coord(rng), coord(rng), turn(rng) };
+
+    std::vector<char> exact(queries);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int q = 0; q < queries; q++) exact[q] = maze.playerCollides(poses[q].x, poses[q].y, poses[q].angle);
+    auto end = std::chrono::high_resolution_clock::now();
+    double exactNs = std::chrono::duration<double, std::nano>(end - start).count() / queries;
+
+    int resolution = std::min(16384, gridN * 32);
+    start = std::chrono::high_resolution_clock::now();
+    maze.bakeOccupancy(resolution);
+    end = std::chrono::high_resolution_clock::now();
+    double bakeMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    std::vector<char> raster(queries);
+    start = std::chrono::high_resolution_clock::now();
+    for (int q = 0; q < queries; q++) raster[q] = maze.playerCollides(poses[q].x, poses[q].y, poses[q].angle);
+    end = std::chrono::high_resolution_clock::now();
+    double rasterNs = std::chrono::duration<double, std::nano>(end - start).count() / queries;
+
+    // the raster is conservative: it may only report poses that come within a texel diagonal of an obstacle
+    const float texel = maze.getOccupancy().getTexel();
+    int mismatches = 0;
+    bool missed = false;
+    float widest = 0.0f;
+    std::vector<ObstacleRecord> records;
+    for (int q = 0; q < queries; q++) {
+        if (exact[q] == raster[q]) continue;
+        mismatches++;
+        missed = missed || exact[q];
+        glm::vec2 center(poses[q].x, poses[q].y);
+        Rhombus poly = maze.rhombusAt(center.x, center.y, poses[q].angle);
+        maze.collectRecords(center - glm::vec2(2.0f * texel), center + glm::vec2(2.0f * texel), records);
+        float gap = INFINITY;
+        for (const ObstacleRecord& record : records) {
+            gap = std::min(gap, polygonSeparation(poly.data(), 4, record.poly.data(), 4, INFINITY));
+        }
+        widest = std::max(widest, gap / texel);
+    }
+
+    std::cout << std::setw(10) << gridN << std::setw(8) << resolution << std::fixed << std::setprecision(1)
+              << std::setw(10) << bakeMs << std::setw(8) << maze.getOccupancy().memoryUsage() / (1024.0 * 1024.0)
+              << std::setw(12) << exactNs << std::setw(12) << rasterNs << std::setw(10) << exactNs / rasterNs
+              << std::setw(8) << maze.getOccupancy().getLevelCount() << std::setprecision(3)
+              << std::setw(12) << 100.0 * mismatches / queries << std::setprecision(2) << std::setw(10) << widest
+              << "\n";
+    return !missed && widest <= std::sqrt(2.0f) * 1.001f;
+}
+
+// Runs the simulation thread for a second with the forward key held, reporting the tick cost apart from rendering
+static void runSimulation(Maze& maze, int agentCount) {
+    AgentSwarm swarm;
+    swarm.spawn(maze, agentCount, 1);
+    Simulation simulation(maze, swarm);
+    simulation.setInput(KeyUp);
+    simulation.start();
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    simulation.stop();
+
+    std::cout << std::setw(10) << maze.getGridN() << std::setw(10) << agentCount << std::setw(8)
+              << simulation.getTickRate() << std::setw(8) << simulation.getTicks() << std::fixed << std::setprecision(3)
+              << std::setw(12) << simulation.getAverageTickMs() << std::setw(10) << simulation.getSkippedTicks() << "\n";
+}
+
+// Walks a player with randomly held arrow keys from the first free pose and records every attempted move
+static void recordWalk(const Maze& maze, const std::vector<Pose>& freePoses, unsigned int seed, int frames,
+                       std::vector<Motion>& motions) {
+    motions.clear();
+    Player player;
+    for (const auto& pose : freePoses) {
+        if (!maze.playerCollides(pose.x, pose.y, player.getAngle())) {
+            player.translate(pose.x - player.getX(), pose.y - player.getY());
+            break;
+        }
+    }
+
+    std::mt19937 rng(seed);
+    const float moveStep = maze.getLongDiag() / 2.0f * player.getMoveSpeed();
+    int key = 0;
+    for (int frame = 0; frame < frames; frame++) {
+        if (frame % 30 == 0) key = static_cast<int>(rng() % 4); // keys stay held for half a second
+        Pose from{ player.getX(), player.getY(), player.getAngle() };
+        Pose to = from;
+        switch (key) {
+        case 0: to.x -= std::sin(from.angle) * moveStep; to.y += std::cos(from.angle) * moveStep; player.moveForward(maze); break;
+        case 1: to.x += std::sin(from.angle) * moveStep; to.y -= std::cos(from.angle) * moveStep; player.moveBackward(maze); break;
+        case 2: to.angle += player.getRotateSpeed(); player.rotateLeft(maze); break;
+        default: to.angle -= player.getRotateSpeed(); player.rotateRight(maze); break;
+        }
+        motions.push_back(Motion{ from, to });
+    }
+}
+
+// Replays the walk's sweeps through the lattice and through a neighbor cache, returns ns per move of each
+static void timeWalk(const Maze& maze, const std::vector<Motion>& motions, NeighborCache& cache,
+                     double& latticeNs, double& cachedNs, int& mismatches) {
+    std::vector<float> times(motions.size());
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t k = 0; k < motions.size(); k++) {
+        const Motion& m = motions[k];
+        times[k] = maze.sweepTimeOfImpact(m.from.x, m.from.y, m.from.angle, m.to.x, m.to.y, m.to.angle);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    latticeNs = std::chrono::duration<double, std::nano>(end - start).count() / motions.size();
+
+    mismatches = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for (size_t k = 0; k < motions.size(); k++) {
+        const Motion& m = motions[k];
+        float t = maze.sweepTimeOfImpact(m.from.x, m.from.y, m.from.angle, m.to.x, m.to.y, m.to.angle, cache);
+        mismatches += (t != times[k]);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    cachedNs = std::chrono::duration<double, std::nano>(end - start).count() / motions.size();
+}
+
+// Generates the maze, then times the discrete and the swept query on random poses and prints one row
+static void runCase(Maze& maze, const BenchCase& bench, unsigned int seed, float skin, std::vector<Pose>& poses,
+                    std::vector<Pose>& freePoses, std::vector<Motion>& motions) {
+    auto start = std::chrono::high_resolution_clock::now();
+    if (bench.implicit) {
+        maze.generateImplicit(bench.gridN, seed);
+        // queries around the middle of the maze, far from the origin the lattice started at
+        float middle = maze.getStep() * (bench.gridN / 2);
+        maze.recenter(middle, middle);
+    } else {
+        maze.generate(bench.gridN, seed);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double genMs = std::chrono::duration<double, std::milli>(end - start).count();
+
+    // random poses over [-0.9, 0.9] (the whole level, or a window of it in implicit mode),
+    // precomputed so only the query is timed
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> coord(-0.9f, 0.9f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+    for (auto& pose : poses) {
+        pose = Pose{ coord(rng), coord(rng), angle(rng) };
+    }
+
+    int hits = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for (const auto& pose : poses) {
+        hits += maze.playerCollides(pose.x, pose.y, pose.angle);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    double queryNs = std::chrono::duration<double, std::nano>(end - start).count() / poses.size();
+
+    // swept test of one arrow-key step forward from every free pose, as Player does each frame
+    freePoses.clear();
+    for (const auto& pose : poses) {
+        if (!maze.playerCollides(pose.x, pose.y, pose.angle)) freePoses.push_back(pose);
+    }
+    const float moveStep = maze.getLongDiag() / 2.0f * 0.02f;
+    int blocked = 0;
+    start = std::chrono::high_resolution_clock::now();
+    for (const auto& pose : freePoses) {
+        float t = maze.sweepTimeOfImpact(pose.x, pose.y, pose.angle,
+                                         pose.x - std::sin(pose.angle) * moveStep,
+                                         pose.y + std::cos(pose.angle) * moveStep, pose.angle);
+        blocked += (t < 1.0f);
+    }
+    end = std::chrono::high_resolution_clock::now();
+    double sweepNs = freePoses.empty() ? 0.0
+        : std::chrono::duration<double, std::nano>(end - start).count() / freePoses.size();
+
+    // one minute of play at 60 fps, replayed with and without the neighbor cache
+    recordWalk(maze, freePoses, seed, 3600, motions);
+    NeighborCache cache(skin);
+    double latticeNs = 0.0, cachedNs = 0.0;
+    int mismatches = 0;
+    timeWalk(maze, motions, cache, latticeNs, cachedNs, mismatches);
+    if (mismatches > 0) {
+        std::cerr << "neighbor cache disagrees with the lattice on " << mismatches << " moves (GRID_N " << bench.gridN << ")\n";
+    }
+    size_t cacheQueries = cache.getHits() + cache.getRebuilds();
+
+    // distance field of the stored layouts (the renderer's glow), 16 texels per cell up to 2048 x 2048
+    double bakeMs = 0.0;
+    if (!bench.implicit) {
+        start = std::chrono::high_resolution_clock::now();
+        maze.bakeDistanceField(std::min(2048, std::max(256, bench.gridN * 16)));
+        end = std::chrono::high_resolution_clock::now();
+        bakeMs = std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    std::cout << std::setw(10) << bench.gridN << std::setw(10) << (bench.implicit ? "implicit" : "stored")
+              << std::setw(8) << seed << std::fixed << std::setprecision(1)
+              << std::setw(12) << genMs
+              << std::setw(12) << queryNs
+              << std::setw(10) << 100.0 * hits / poses.size()
+              << std::setw(12) << sweepNs
+              << std::setw(10) << (freePoses.empty() ? 0.0 : 100.0 * blocked / freePoses.size())
+              << std::setw(10) << maze.memoryUsage() / (1024.0 * 1024.0)
+              << std::setw(10) << latticeNs
+              << std::setw(10) << cachedNs
+              << std::setw(8) << (cacheQueries ? 100.0 * cache.getHits() / cacheQueries : 0.0)
+              << std::setw(10) << cache.getRebuilds()
+              << std::setw(10) << bakeMs
+              << std::setw(10) << maze.getDistanceField().memoryUsage() / (1024.0 * 1024.0) << "\n";
+}
+
+int main(int argc, char** argv) {
+    bool large = false;
+    std::vector<const char*> args;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--large") == 0) large = true;
+        else args.push_back(argv[i]);
+    }
+    int queries = 1000000;
+    int seedCount = 3;
+    if (args.size() >= 1) queries = std::max(1, std::atoi(args[0]));
+    if (args.size() >= 2) seedCount = std::max(1, std::atoi(args[1]));
+    float skin = 0.5f;
+    if (args.size() >= 3) skin = std::max(0.0f, static_cast<float>(std::atof(args[2])));
+
+    if (!checkDeterminism(12345)) {
+        std::cerr << "generation is not deterministic across thread counts\n";
+        return 1;
+    }
+    if (!checkSegmentKernels(12345)) {
+        std::cerr << "a SIMD segment kernel disagrees with the scalar reference\n";
+        return 1;
+    }
+    std::cout << "\n";
+
+    std::vector<BenchCase> cases = {
+        { 10, false }, { 100, false }, { 300, false }, { 1000, false }, { 2000, false },
+        { 1000, true }, { 1000000, true }
+    };
+    if (large) cases.insert(cases.begin() + 5, BenchCase{ 5000, false });
+
+    std::cout << std::setw(10) << "GRID_N" << std::setw(10) << "mode" << std::setw(8) << "seed"
+              << std::setw(12) << "gen ms" << std::setw(12) << "ns/query" << std::setw(10) << "hits %"
+              << std::setw(12) << "sweep ns" << std::setw(10) << "stop %" << std::setw(10) << "MB"
+              << std::setw(10) << "walk ns" << std::setw(10) << "cached" << std::setw(8) << "hit %"
+              << std::setw(10) << "rebuilds" << std::setw(10) << "sdf ms" << std::setw(10) << "sdf MB" << "\n";
+
+    Maze maze;
+    std::vector<Pose> poses(queries);
+    std::vector<Pose> freePoses;
+    std::vector<Motion> motions;
+    for (const BenchCase& bench : cases) {
+        for (int s = 0; s < seedCount; s++) {
+            runCase(maze, bench, 1 + s * 7919, skin, poses, freePoses, motions);
+        }
+    }
+
+    std::cout << "\n";
+    if (!checkFlowVerdicts(seedCount)) {
+        std::cerr << "the flow field calls a level unsolvable that the finer reference search solves\n";
+        return 1;
+    }
+    std::cout << "\n" << std::setw(10) << "GRID_N" << std::setw(8) << "seed" << std::setw(12) << "flow ms"
+              << std::setw(10) << "solvable" << std::setw(10) << "MB" << "\n";
+    for (int gridN : { 10, 100, 300, 1000 }) {
+        // a GRID_N 1000 build takes about five seconds on one core, one seed is enough
+        for (int s = 0; s < (gridN >= 1000 ? 1 : seedCount); s++) {
+            unsigned int seed = 1 + s * 7919;
+            maze.generate(gridN, seed);
+            FlowField flow;
+            auto start = std::chrono::high_resolution_clock::now();
+            flow.build(maze);
+            auto end = std::chrono::high_resolution_clock::now();
+            std::cout << std::setw(10) << gridN << std::setw(8) << seed << std::fixed << std::setprecision(1)
+                      << std::setw(12) << std::chrono::duration<double, std::milli>(end - start).count()
+                      << std::setw(10) << (flow.isSolvable() ? "yes" : "no")
+                      << std::setw(10) << flow.memoryUsage() / (1024.0 * 1024.0) << "\n";
+        }
+    }
+
+    std::cout << "\n" << std::setw(10) << "GRID_N" << std::setw(8) << "texels" << std::setw(10) << "bake ms"
+              << std::setw(8) << "MB" << std::setw(12) << "exact ns" << std::setw(12) << "raster ns"
+              << std::setw(10) << "speedup" << std::setw(8) << "levels" << std::setw(12) << "mismatch %"
+              << std::setw(10) << "widest" << "\n";
+    bool rasterAgrees = true;
+    for (int gridN : { 100, 300, 1000, 2000 }) {
+        rasterAgrees = runOccupancy(gridN, queries) && rasterAgrees;
+    }
+    if (!rasterAgrees) {
+        std::cerr << "the occupancy raster disagrees with the exact test by more than a texel\n";
+        return 1;
+    }
+
+    std::cout << "\n" << std::setw(10) << "GRID_N" << std::setw(10) << "agents" << std::setw(8) << "ticks"
+              << std::setw(12) << "ms/tick" << std::setw(14) << "M steps/s" << std::setw(10) << "arrived" << "\n";
+    maze.generate(30, 1);
+    for (int agentCount : { 1000, 10000, 100000 }) {
+        runSwarm(maze, agentCount, 1);
+    }
+
+    std::cout << "\n" << std::setw(10) << "GRID_N" << std::setw(10) << "agents" << std::setw(8) << "Hz"
+              << std::setw(8) << "ticks" << std::setw(12) << "ms/tick" << std::setw(10) << "skipped" << "\n";
+    for (int agentCount : { 0, 1000 }) {
+        runSimulation(maze, agentCount);
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+// Headless playback of a session recorded by OpenGLTriangle (7th argument): rebuilds the level from the recorded
+// seed and GRID_N, feeds the recorded keys tick by tick to the same Simulation step the game runs, as fast as it
+// goes, and reports the final pose, the finish time and the collision query cost. Two builds replaying the same
+// file can be compared directly; the exit code is 1 when the replay does not end where the recording did.
+// Usage: maze2d_replay <file.l2dr> [repeats]
+#include <glm/glm.hpp>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include "Maze.hpp"
+#include "AgentSwarm.hpp"
+#include "Simulation.hpp"
+#include "InputRecording.hpp"
+
+struct ReplayResult {
+    glm::vec2 position;
+    float angle;
+    int64_t finishTick;
+    size_t ticks;
+    size_t queries;
+    size_t cacheHits;   // queries the distance field could not clear, answered from the neighbor cache
+    size_t cacheRebuilds;
+    double stepSeconds; // inside Simulation::advance
+    double wallSeconds; // whole playback, including reading the stream
+};
+
+static ReplayResult replay(InputRecording& recording) {
+    Maze maze;
+    if (recording.isImplicit()) maze.generateImplicit(recording.getGridN(), recording.getSeed());
+    else maze.generate(recording.getGridN(), recording.getSeed());
+    maze.bakeDistanceField(recording.getFieldResolution());
+
+    // agents never touch the player, the replay leaves them out
+    AgentSwarm swarm;
+    Simulation simulation(maze, swarm, recording.getTickRate());
+
+    recording.rewind();
+    uint64_t tick;
+    unsigned int keys;
+    auto start = std::chrono::steady_clock::now();
+    while (recording.next(tick, keys)) simulation.advance(static_cast<size_t>(tick), keys);
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const Player& player = simulation.getPlayer();
+    const NeighborCache& neighbors = player.getNeighborCache();
+    ReplayResult result;
+    result.position = glm::vec2(player.getX(), player.getY());
+    result.angle = player.getAngle();
+    result.finishTick = simulation.getFinishTick();
+    result.ticks = simulation.getTicks();
+    result.queries = player.getCollisionQueries();
+    result.cacheHits = neighbors.getHits();
+    result.cacheRebuilds = neighbors.getRebuilds();
+    result.stepSeconds = simulation.getAverageTickMs() * simulation.getTicks() / 1000.0;
+    result.wallSeconds = wall;
+    return result;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage: maze2d_replay <file.l2dr> [repeats]\n";
+        return 2;
+    }
+    InputRecording recording;
+    if (!recording.load(argv[1])) {
+        std::cerr << "Cannot read the input recording " << argv[1] << "\n";
+        return 2;
+    }
+    int repeats = argc >= 3 ? std::max(1, std::atoi(argv[2])) : 1;
+
+    const double tickSeconds = 1.0 / std::max(1, recording.getTickRate());
+    std::cout << "Recording: GRID_N " << recording.getGridN() << (recording.isImplicit() ? " (implicit)" : "")
+              << ", seed " << recording.getSeed() << ", field " << recording.getFieldResolution() << ", "
+              << recording.getTickCount() << " ticks at " << recording.getTickRate() << " Hz ("
+              << recording.getTickCount() * tickSeconds << " s), " << recording.getStreamBytes() << " bytes of input\n";
+
+    // the fastest of the repeats, all of them have to end the same way
+    ReplayResult best = replay(recording);
+    bool stable = true;
+    for (int r = 1; r < repeats; r++) {
+        ReplayResult result = replay(recording);
+        stable = stable && result.position == best.position && result.angle == best.angle &&
+                 result.finishTick == best.finishTick && result.queries == best.queries;
+        if (result.wallSeconds < best.wallSeconds) best = result;
+    }
+
+    double played = best.ticks * tickSeconds;
+    std::cout << std::fixed << std::setprecision(6);
+    std::cout << "Final pose: (" << best.position.x << ", " << best.position.y << ") angle " << best.angle << "\n";
+    if (best.finishTick == InputRecording::notFinished) std::cout << "Finish: not reached\n";
+    else std::cout << "Finish: tick " << best.finishTick << " (" << best.finishTick * tickSeconds << " s)\n";
+    std::cout << std::setprecision(3);
+    std::cout << "Playback: " << best.ticks << " ticks in " << best.wallSeconds * 1000.0 << " ms, "
+              << (best.wallSeconds > 0.0 ? played / best.wallSeconds : 0.0) << "x real time, "
+              << (best.ticks ? best.stepSeconds * 1e6 / best.ticks : 0.0) << " us per tick\n";
+    std::cout << "Collision queries: " << best.queries << " in " << best.stepSeconds * 1000.0 << " ms of ticks, "
+              << (best.queries ? best.stepSeconds * 1e9 / best.queries : 0.0) << " ns per query, neighbor cache "
+              << best.cacheHits << " hits, " << best.cacheRebuilds << " rebuilds\n";
+
+    bool matches = best.position == recording.getFinalPosition() && best.angle == recording.getFinalAngle() &&
+                   best.finishTick == recording.getFinishTick();
+    std::cout << "Matches the recording: " << (matches ? "yes" : "NO") << (stable ? "" : ", repeats differ") << "\n";
+    return matches && stable ? 0 : 1;
+}
@@ -0,0 +1,47 @@
+#version 330 core
+in vec3 vertexColor;
+in vec2 levelPos;
+flat in int kind;
+out vec4 FragColor;
+
+uniform float time;
+uniform float playerBrightness; // brighter the closer the player gets to the finish
+
+// signed distance to the nearest obstacle, baked by Maze::bakeDistanceField
+uniform sampler2D distanceField;
+uniform bool hasField;
+uniform vec2 fieldMin;
+uniform vec2 fieldSize;
+uniform float glowRadius;
+
+const int BACKGROUND = 0;
+const int PLAYER = 4;
+
+void main()
+{
+    if (kind == PLAYER) {
+        FragColor = vec4(vertexColor * playerBrightness, 1.0);
+        return;
+    }
+    if (kind != BACKGROUND) {
+        FragColor = vec4(vertexColor, 1.0);
+        return;
+    }
+
+    // Computes the position of color in the diagonal direction
+    float diagonal = (gl_FragCoord.x + gl_FragCoord.y) * 0.007 - time;
+
+    // sin wave between 0 and 1
+    float wave = 0.5 + 0.5 * sin(diagonal);
+
+    vec3 finalColor = vertexColor + vec3(wave) * 0.4;
+    finalColor = clamp(finalColor, 0.0, 0.5);
+
+    // proximity glow fading out glowRadius away from the obstacles
+    if (hasField) {
+        float distance = texture(distanceField, (levelPos - fieldMin) / fieldSize).r;
+        float glow = 1.0 - smoothstep(0.0, glowRadius, distance);
+        finalColor += vec3(0.35, 0.3, 0.6) * glow * (0.75 + 0.25 * wave);
+    }
+    FragColor = vec4(finalColor, 1.0);
+}
@@ -0,0 +1,59 @@
+#version 330 core
+layout (location = 0) in vec4 aPrimitive; // center (x, y), angle, kind - one record per primitive
+
+uniform vec2 cameraOffset;     // (0, 0) when the whole level fits the screen
+uniform vec2 rhombusLocal[4];  // top, right, bottom, left vertex of the shared rhombus
+uniform vec2 finishLocal[3];   // finish triangle around its center
+
+out vec3 vertexColor;
+out vec2 levelPos;  // position in the level, where the distance field is sampled
+flat out int kind;
+
+const int BACKGROUND = 0;
+const int OBSTACLE = 1;
+const int AGENT = 2;
+const int FINISH = 3;
+const int PLAYER = 4;
+
+// Two triangles per rhombus: top, right, bottom and bottom, left, top
+const int rhombusIndex[6] = int[6](0, 1, 2, 2, 3, 0);
+
+// Background square with its corner colours (black, blue, green, red)
+const vec2 backgroundCorner[6] = vec2[6](vec2(-0.9, -0.9), vec2(-0.9, 0.9), vec2(0.9, 0.9),
+                                         vec2(-0.9, -0.9), vec2(0.9, 0.9), vec2(0.9, -0.9));
+const vec3 backgroundColor[6] = vec3[6](vec3(0.0, 0.0, 0.0), vec3(0.0, 0.0, 1.0), vec3(0.0, 1.0, 0.0),
+                                        vec3(0.0, 0.0, 0.0), vec3(0.0, 1.0, 0.0), vec3(1.0, 0.0, 0.0));
+
+void main()
+{
+    kind = int(aPrimitive.w);
+
+    if (kind == BACKGROUND) {
+        // fixed on the screen, like the level frame it marks
+        vec2 corner = backgroundCorner[gl_VertexID];
+        vertexColor = backgroundColor[gl_VertexID];
+        levelPos = corner + cameraOffset;
+        gl_Position = vec4(corner, 0.0, 1.0);
+        return;
+    }
+
+    vec2 local;
+    if (kind == FINISH) {
+        // the last three vertices collapse onto the first, a zero-area triangle
+        local = finishLocal[gl_VertexID < 3 ? gl_VertexID : 0];
+        vertexColor = vec3(1.0, 0.84, 0.0);
+    } else {
+        int vertex = rhombusIndex[gl_VertexID];
+        local = rhombusLocal[vertex];
+        if (kind == OBSTACLE) vertexColor = vec3(1.0, 0.2, 0.6);
+        else if (kind == AGENT) vertexColor = vec3(0.29, 0.96, 1.0);
+        else vertexColor = (vertex == 2) ? vec3(0.29, 0.96, 1.0) : vec3(1.0, 0.84, 0.0); // gold with a cyan tail
+    }
+
+    // Rotate around the primitive's center, then move it relative to the camera
+    float sin = sin(aPrimitive.z);
+    float cos = cos(aPrimitive.z);
+    vec2 pos = vec2(local.x * cos - local.y * sin, local.x * sin + local.y * cos) + aPrimitive.xy;
+    levelPos = pos;
+    gl_Position = vec4(pos - cameraOffset, 0.0, 1.0);
+}
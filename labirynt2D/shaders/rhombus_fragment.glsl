@@ -1,9 +0,0 @@
-#version 330 core
-out vec4 FragColor;
-
-const vec3 PINK = vec3(1.0, 0.2, 0.6);
-
-void main()
-{
-    FragColor = vec4(PINK, 1.0);
-}
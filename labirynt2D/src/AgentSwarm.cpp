@@ -0,0 +1,187 @@
+#include "AgentSwarm.hpp"
+#include "Player.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+namespace {
+
+const float PI = 3.14159265358979323846f;
+const int batchSize = 256;
+// Cells across the agents' box at most, a wider spread gets coarser cells
+const int maxCellColumns = 1024;
+
+uint32_t nextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+}
+
+AgentSwarm::AgentSwarm()
+    : cellOrigin(0.0f), cellSize(1.0f), cellColumns(1), flow(nullptr), steps(0), arrivals(0) {
+    Player reference;
+    startAngle = reference.getAngle();
+    moveSpeed = reference.getMoveSpeed();
+    rotateSpeed = reference.getRotateSpeed();
+}
+
+void AgentSwarm::spawn(const Maze& maze, int count, unsigned int seed) {
+    poses.clear();
+    states.clear();
+    spawnPoints.clear();
+    for (NeighborCache& cache : caches) cache.invalidate();
+    steps = 0;
+    arrivals = 0;
+
+    // a few hundred distinct free spots are plenty, agents pass through each other
+    uint32_t rng = seed * 2654435761u + 1;
+    const int spawnPointCount = std::min(count, 512);
+    for (int attempt = 0; static_cast<int>(spawnPoints.size()) < spawnPointCount && attempt < spawnPointCount * 100; attempt++) {
+        float x = -0.9f + 1.8f * (nextRandom(rng) >> 8) / 16777216.0f;
+        float y = -0.9f + 1.8f * (nextRandom(rng) >> 8) / 16777216.0f;
+        if (!maze.playerCollides(x, y, startAngle)) spawnPoints.push_back(glm::vec2(x, y));
+    }
+    if (spawnPoints.empty()) {
+        Player reference;
+        spawnPoints.push_back(glm::vec2(reference.getX(), reference.getY()));
+    }
+
+    poses.resize(count);
+    states.resize(count);
+    for (int k = 0; k < count; k++) {
+        poses[k] = ObstacleInstance{ spawnPoints[k % spawnPoints.size()], startAngle };
+        states[k] = AgentState{ (seed + k) * 2654435761u | 1, 0, 0 };
+    }
+}
+
+void AgentSwarm::sortByCell(const Maze& maze) {
+    glm::vec2 boxMin(poses.front().center), boxMax(boxMin);
+    for (const ObstacleInstance& pose : poses) {
+        boxMin = glm::min(boxMin, pose.center);
+        boxMax = glm::max(boxMax, pose.center);
+    }
+    float extent = std::max(boxMax.x - boxMin.x, boxMax.y - boxMin.y);
+    cellOrigin = boxMin;
+    cellSize = std::max(maze.getStep(), extent / maxCellColumns);
+    cellColumns = static_cast<int>(extent / cellSize) + 1;
+
+    cellOf.resize(poses.size());
+    cellStarts.assign(static_cast<size_t>(cellColumns) * cellColumns + 1, 0);
+    for (size_t k = 0; k < poses.size(); k++) {
+        glm::vec2 cell = glm::min(glm::floor((poses[k].center - cellOrigin) / cellSize), glm::vec2(cellColumns - 1.0f));
+        cellOf[k] = static_cast<uint32_t>(cell.y) * cellColumns + static_cast<uint32_t>(cell.x);
+        cellStarts[cellOf[k] + 1]++;
+    }
+    for (size_t c = 1; c < cellStarts.size(); c++) cellStarts[c] += cellStarts[c - 1];
+
+    sortedPoses.resize(poses.size());
+    sortedStates.resize(states.size());
+    for (size_t k = 0; k < poses.size(); k++) {
+        uint32_t slot = cellStarts[cellOf[k]]++;
+        sortedPoses[slot] = poses[k];
+        sortedStates[slot] = states[k];
+    }
+    poses.swap(sortedPoses);
+    states.swap(sortedStates);
+}
+
+void AgentSwarm::tick(const Maze& maze, float time, unsigned int threadCount) {
+    int batchCount = static_cast<int>((poses.size() + batchSize - 1) / batchSize);
+    if (batchCount == 0) return;
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::min(threadCount, static_cast<unsigned int>(batchCount));
+    if (!pool || pool->size() != threadCount) {
+        pool.reset(new WorkerPool(threadCount));
+        caches.resize(threadCount);
+    }
+
+    // neighbours in the lattice become neighbours in memory, so consecutive agents share their cached obstacles
+    sortByCell(maze);
+
+    std::atomic<int> nextBatch(0);
+    std::atomic<uint64_t> arrived(0);
+    pool->run([&](unsigned int t) {
+        NeighborCache& cache = caches[t];
+        uint64_t local = 0;
+        for (int batch = nextBatch++; batch < batchCount; batch = nextBatch++) {
+            size_t end = std::min(poses.size(), static_cast<size_t>(batch + 1) * batchSize);
+            for (size_t k = static_cast<size_t>(batch) * batchSize; k < end; k++) {
+                // the whole cell at once: the moves of every agent in it are then answered from the same records
+                glm::vec2 cell = glm::min(glm::floor((poses[k].center - cellOrigin) / cellSize), glm::vec2(cellColumns - 1.0f));
+                glm::vec2 cellMin = cellOrigin + cell * cellSize;
+                cache.prepare(maze, cellMin, cellMin + glm::vec2(cellSize));
+                local += step(maze, poses[k], states[k], time, cache);
+            }
+        }
+        arrived += local;
+    });
+
+    steps += poses.size();
+    arrivals += arrived;
+}
+
+void AgentSwarm::moveAlong(const Maze& maze, ObstacleInstance& pose, int localVertex, NeighborCache& cache) const {
+    const glm::vec2& v = maze.getLocal()[localVertex];
+    float dx = (v.x * std::cos(pose.angle) - v.y * std::sin(pose.angle)) * moveSpeed;
+    float dy = (v.x * std::sin(pose.angle) + v.y * std::cos(pose.angle)) * moveSpeed;
+    maze.slideMove(pose.center.x, pose.center.y, pose.angle, pose.center.x + dx, pose.center.y + dy, pose.angle, cache);
+}
+
+void AgentSwarm::rotate(const Maze& maze, ObstacleInstance& pose, float by, NeighborCache& cache) const {
+    maze.slideMove(pose.center.x, pose.center.y, pose.angle, pose.center.x, pose.center.y, pose.angle + by, cache);
+}
+
+bool AgentSwarm::step(const Maze& maze, ObstacleInstance& pose, AgentState& state, float time, NeighborCache& cache) const {
+    if (maze.playerReachesFinish(pose.center.x, pose.center.y, pose.angle, time)) {
+        pose = ObstacleInstance{ spawnPoints[nextRandom(state.rng) % spawnPoints.size()], startAngle };
+        state.wanderTicks = 0;
+        return true;
+    }
+
+    if (state.wanderTicks > 0) {
+        state.wanderTicks--;
+        if (state.wanderAction == 0) moveAlong(maze, pose, 2, cache);
+        else if (state.wanderAction == 1) rotate(maze, pose, rotateSpeed, cache);
+        else rotate(maze, pose, -rotateSpeed, cache);
+        return false;
+    }
+
+    // heading of the forward (top) vertex towards the finish, wrapped to [-PI, PI]
+    glm::vec2 toFinish = maze.getFinishCenter() - pose.center;
+    if (flow) {
+        glm::vec2 direction = flow->directionAt(pose.center);
+        if (direction.x != 0.0f || direction.y != 0.0f) toFinish = direction;
+    }
+    float turn = std::atan2(-toFinish.x, toFinish.y) - pose.angle;
+    turn = std::remainder(turn, 2.0f * PI);
+
+    if (std::abs(turn) > rotateSpeed) {
+        float angle = pose.angle;
+        rotate(maze, pose, turn > 0.0f ? rotateSpeed : -rotateSpeed, cache);
+        if (pose.angle != angle) return false;
+    } else {
+        float x = pose.center.x, y = pose.center.y;
+        moveAlong(maze, pose, 0, cache);
+        if (pose.center.x != x || pose.center.y != y) return false;
+    }
+
+    // blocked: back off or turn away for a random while
+    uint32_t r = nextRandom(state.rng);
+    state.wanderAction = r % 3;
+    state.wanderTicks = 10 + (r >> 8) % 40;
+    return false;
+}
+
+void AgentSwarm::translate(float dx, float dy) {
+    for (ObstacleInstance& pose : poses) {
+        pose.center += glm::vec2(dx, dy);
+    }
+    for (glm::vec2& spot : spawnPoints) {
+        spot += glm::vec2(dx, dy);
+    }
+    // the cached obstacles are still in the old frame
+    for (NeighborCache& cache : caches) cache.invalidate();
+}
@@ -0,0 +1,82 @@
+#ifndef AGENTSWARM_HPP
+#define AGENTSWARM_HPP
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "Maze.hpp"
+#include "NeighborCache.hpp"
+#include "FlowField.hpp"
+#include "WorkerPool.hpp"
+
+// Stress mode: many autonomous player-shaped rhombi heading for the finish. Agents only collide with the maze,
+// so a tick moves all of them in one batched pass on a pool of threads that outlives the tick. An agent is a
+// pose and a random stream, no Player of its own: the agents are ordered by lattice cell every tick and each
+// thread answers its run of them from one neighbor cache, fetched once per cell. The result does not depend on
+// the thread count.
+class AgentSwarm {
+public:
+    AgentSwarm();
+
+    // Places count agents on random free poses of [-0.9, 0.9] (the visible level)
+    void spawn(const Maze& maze, int count, unsigned int seed);
+
+    // Agents follow the field's directions where it has one instead of heading straight for the finish. The field
+    // may still be building on its own thread, it has no directions until it is done
+    void setFlowField(const FlowField* flow) { this->flow = flow; }
+
+    // One move per agent: turn towards the finish, step forward, wander for a while when blocked.
+    // Agents that reach the finish start again from a new free pose
+    void tick(const Maze& maze, float time, unsigned int threadCount = 0);
+
+    // Follows a lattice origin shift of the maze, like Player::translate
+    void translate(float dx, float dy);
+
+    // Render instances of every agent (center and angle), drawn with the obstacle rhombus
+    void collectInstances(std::vector<ObstacleInstance>& result) const { result = poses; }
+
+    size_t size() const { return poses.size(); }
+    // Agent moves and finish arrivals since spawn
+    uint64_t getSteps() const { return steps; }
+    uint64_t getArrivals() const { return arrivals; }
+
+private:
+    // Everything of an agent but its pose
+    struct AgentState {
+        uint32_t rng;       // xorshift32 state
+        int wanderTicks;    // left of the current detour
+        int wanderAction;   // 0 - back off, 1 - turn left, 2 - turn right
+    };
+
+    std::vector<ObstacleInstance> poses; // center and angle, already in render instance form
+    std::vector<AgentState> states;      // same order as poses
+    std::vector<ObstacleInstance> sortedPoses; // the next order of both, reused every tick
+    std::vector<AgentState> sortedStates;
+    std::vector<uint32_t> cellOf;        // cell of every agent and agents per cell for the counting sort
+    std::vector<uint32_t> cellStarts;
+    glm::vec2 cellOrigin;                // corner of the cells the agents were sorted into
+    float cellSize;
+    int cellColumns;
+
+    std::vector<glm::vec2> spawnPoints; // free poses reused for respawning
+    const FlowField* flow;
+    std::unique_ptr<WorkerPool> pool;
+    std::vector<NeighborCache> caches;   // one per pool thread
+    float startAngle;                    // Player's start angle and speeds
+    float moveSpeed;
+    float rotateSpeed;
+    uint64_t steps;
+    uint64_t arrivals;
+
+    // Orders the agents by the cell their center is in, row by row over the box around all of them
+    void sortByCell(const Maze& maze);
+    // Moves one agent, returns true when it reached the finish
+    bool step(const Maze& maze, ObstacleInstance& pose, AgentState& state, float time, NeighborCache& cache) const;
+    // Step along the rhombus' long diagonal towards its top (0) or bottom (2) vertex, as Player moves
+    void moveAlong(const Maze& maze, ObstacleInstance& pose, int localVertex, NeighborCache& cache) const;
+    void rotate(const Maze& maze, ObstacleInstance& pose, float by, NeighborCache& cache) const;
+};
+
+#endif
@@ -0,0 +1,80 @@
+#include "ConvexCollision.hpp"
+#include <cmath>
+
+namespace {
+
+void projectPolygon(const glm::vec2* poly, int count, const glm::vec2& axis, float& minProj, float& maxProj) {
+    minProj = maxProj = glm::dot(poly[0], axis);
+    for (int i = 1; i < count; i++) {
+        float p = glm::dot(poly[i], axis);
+        if (p < minProj) minProj = p;
+        if (p > maxProj) maxProj = p;
+    }
+}
+
+// Tests the edge normals of 'edges' as candidate separating axes, keeps the shortest way out for A
+bool testAxes(const glm::vec2* edges, int edgeCount, const glm::vec2* a, int countA,
+              const glm::vec2* b, int countB, float& bestDepth, glm::vec2& bestAxis) {
+    for (int i = 0; i < edgeCount; i++) {
+        glm::vec2 edge = edges[(i + 1) % edgeCount] - edges[i];
+        float len = glm::length(edge);
+        if (len == 0.0f) continue;
+        glm::vec2 axis = glm::vec2(-edge.y, edge.x) / len;
+
+        float minA, maxA, minB, maxB;
+        projectPolygon(a, countA, axis, minA, maxA);
+        projectPolygon(b, countB, axis, minB, maxB);
+
+        // how far A has to travel along +axis or -axis to leave B, the shorter way wins
+        float pushForward = maxB - minA;
+        float pushBackward = maxA - minB;
+        if (pushForward <= 0.0f || pushBackward <= 0.0f) return false; // separating axis found
+
+        if (pushForward < bestDepth) {
+            bestDepth = pushForward;
+            bestAxis = axis;
+        }
+        if (pushBackward < bestDepth) {
+            bestDepth = pushBackward;
+            bestAxis = -axis;
+        }
+    }
+    return true;
+}
+
+// Widest gap along the edge normals of 'edges', early out once it reaches 'enough'
+float widestGap(const glm::vec2* edges, int edgeCount, const glm::vec2* a, int countA,
+                const glm::vec2* b, int countB, float gap, float enough) {
+    for (int i = 0; i < edgeCount && gap < enough; i++) {
+        glm::vec2 edge = edges[(i + 1) % edgeCount] - edges[i];
+        float len = glm::length(edge);
+        if (len == 0.0f) continue;
+        glm::vec2 axis = glm::vec2(-edge.y, edge.x) / len;
+
+        float minA, maxA, minB, maxB;
+        projectPolygon(a, countA, axis, minA, maxA);
+        projectPolygon(b, countB, axis, minB, maxB);
+        gap = std::fmax(gap, std::fmax(minB - maxA, minA - maxB));
+    }
+    return gap;
+}
+
+}
+
+bool polygonsCollide(const glm::vec2* a, int countA, const glm::vec2* b, int countB, Contact* contact) {
+    float depth = INFINITY;
+    glm::vec2 axis(0.0f);
+    if (!testAxes(a, countA, a, countA, b, countB, depth, axis)) return false;
+    if (!testAxes(b, countB, a, countA, b, countB, depth, axis)) return false;
+
+    if (contact) {
+        contact->normal = axis;
+        contact->depth = depth;
+    }
+    return true;
+}
+
+float polygonSeparation(const glm::vec2* a, int countA, const glm::vec2* b, int countB, float enough) {
+    float gap = widestGap(a, countA, a, countA, b, countB, 0.0f, enough);
+    return widestGap(b, countB, a, countA, b, countB, gap, enough);
+}
@@ -0,0 +1,20 @@
+#ifndef CONVEXCOLLISION_HPP
+#define CONVEXCOLLISION_HPP
+
+#include <glm/glm.hpp>
+
+// Result of an overlapping pair: moving polygon A by normal * depth separates it from polygon B
+struct Contact {
+    glm::vec2 normal;
+    float depth;
+};
+
+// Separating axis test for two convex polygons (any winding). Unlike segment crossings it also
+// reports full containment. On overlap fills contact (if given) with the minimum translation.
+bool polygonsCollide(const glm::vec2* a, int countA, const glm::vec2* b, int countB, Contact* contact = nullptr);
+
+// Lower bound of the distance between two convex polygons: the widest gap between their projections on
+// any edge normal, 0 when they overlap. Stops early once a gap of at least 'enough' is found
+float polygonSeparation(const glm::vec2* a, int countA, const glm::vec2* b, int countB, float enough);
+
+#endif
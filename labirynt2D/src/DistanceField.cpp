@@ -0,0 +1,115 @@
+#include "DistanceField.hpp"
+#include "Maze.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+namespace {
+
+const int tileSize = 32;
+
+// Signed distance from p to a convex polygon, negative inside
+float signedDistance(const glm::vec2& p, const Rhombus& poly) {
+    float distanceSq = 1e30f;
+    int positive = 0, negative = 0;
+    for (int i = 0; i < 4; i++) {
+        glm::vec2 a = poly[i];
+        glm::vec2 edge = poly[(i + 1) % 4] - a;
+        glm::vec2 offset = p - a;
+        float t = glm::clamp(glm::dot(offset, edge) / glm::dot(edge, edge), 0.0f, 1.0f);
+        glm::vec2 closest = offset - edge * t;
+        distanceSq = std::min(distanceSq, glm::dot(closest, closest));
+
+        float side = edge.x * offset.y - edge.y * offset.x;
+        positive += (side > 0.0f);
+        negative += (side < 0.0f);
+    }
+    float distance = std::sqrt(distanceSq);
+    return (positive == 0 || negative == 0) ? -distance : distance;
+}
+
+}
+
+DistanceField::DistanceField()
+    : resolution(0), boxMin(0.0f), boxMax(0.0f), texel(0.0f), maxDistance(0.0f) {
+}
+
+void DistanceField::bake(const Maze& maze, const glm::vec2& boxMin, const glm::vec2& boxMax, int resolution,
+                         float maxDistance, unsigned int threadCount) {
+    this->resolution = resolution;
+    this->boxMin = boxMin;
+    this->boxMax = boxMax;
+    this->maxDistance = maxDistance;
+    // square texels, the longer side of the box decides their size
+    texel = std::max(boxMax.x - boxMin.x, boxMax.y - boxMin.y) / resolution;
+    values.assign(static_cast<size_t>(resolution) * resolution, maxDistance);
+
+    int tilesPerSide = (resolution + tileSize - 1) / tileSize;
+    int tileCount = tilesPerSide * tilesPerSide;
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::min(threadCount, static_cast<unsigned int>(tileCount));
+
+    // tiles are handed out one by one, dense and sparse parts of the level balance out
+    std::atomic<int> nextTile(0);
+    auto work = [&]() {
+        for (int tile = nextTile++; tile < tileCount; tile = nextTile++) {
+            bakeTile(maze, tile % tilesPerSide, tile / tilesPerSide);
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned int t = 1; t < threadCount; t++) workers.emplace_back(work);
+    work();
+    for (std::thread& worker : workers) worker.join();
+}
+
+void DistanceField::bakeTile(const Maze& maze, int tileX, int tileY) {
+    int xBegin = tileX * tileSize, xEnd = std::min(resolution, xBegin + tileSize);
+    int yBegin = tileY * tileSize, yEnd = std::min(resolution, yBegin + tileSize);
+    glm::vec2 tileMin = boxMin + glm::vec2(xBegin, yBegin) * texel;
+    glm::vec2 tileMax = boxMin + glm::vec2(xEnd, yEnd) * texel;
+    glm::vec2 searchReach(maxDistance);
+
+    // every obstacle closer than maxDistance to some texel of the tile, laid out by cell so each texel
+    // reads only the few cells around it however many the tile spans
+    const ObstacleGrid& grid = maze.getGrid();
+    CellRange tileRange = grid.cellsOverlapping(tileMin - searchReach, tileMax + searchReach);
+    if (tileRange.iMin > tileRange.iMax || tileRange.jMin > tileRange.jMax) return;
+    int width = tileRange.iMax - tileRange.iMin + 1;
+    std::vector<Rhombus> polys(static_cast<size_t>(width) * (tileRange.jMax - tileRange.jMin + 1));
+    std::vector<char> present(polys.size(), 0);
+    grid.forEachObstacle(tileRange, [&](int i, int j) {
+        size_t cell = static_cast<size_t>(j - tileRange.jMin) * width + (i - tileRange.iMin);
+        polys[cell] = maze.obstacleAt(i, j);
+        present[cell] = 1;
+        return false;
+    });
+
+    const float reach = maze.getLongDiag() / 2.0f;
+    for (int y = yBegin; y < yEnd; y++) {
+        for (int x = xBegin; x < xEnd; x++) {
+            glm::vec2 p = boxMin + (glm::vec2(x, y) + glm::vec2(0.5f)) * texel;
+            CellRange range = grid.cellsOverlapping(p - searchReach, p + searchReach);
+            float best = maxDistance;
+            for (int j = std::max(range.jMin, tileRange.jMin); j <= std::min(range.jMax, tileRange.jMax); j++) {
+                for (int i = std::max(range.iMin, tileRange.iMin); i <= std::min(range.iMax, tileRange.iMax); i++) {
+                    size_t cell = static_cast<size_t>(j - tileRange.jMin) * width + (i - tileRange.iMin);
+                    if (!present[cell]) continue;
+
+                    // an obstacle is at least |p - center| - reach away
+                    glm::vec2 offset = grid.cellCenter(i, j) - p;
+                    float far = best + reach;
+                    if (best > 0.0f && glm::dot(offset, offset) >= far * far) continue;
+                    best = std::min(best, signedDistance(p, polys[cell]));
+                }
+            }
+            values[static_cast<size_t>(y) * resolution + x] = best;
+        }
+    }
+}
+
+void DistanceField::clear() {
+    resolution = 0;
+    values.clear();
+    values.shrink_to_fit();
+}
@@ -0,0 +1,44 @@
+#ifndef DISTANCEFIELD_HPP
+#define DISTANCEFIELD_HPP
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstddef>
+
+class Maze;
+
+// Signed distance to the nearest obstacle, sampled on a square texel grid over a box of the level
+// (negative inside a rhombus). Values are truncated at maxDistance, which keeps every stored value a lower
+// bound of the true distance. Baked once per layout and uploaded as a GL_R32F texture for the proximity glow.
+class DistanceField {
+public:
+    DistanceField();
+
+    // Exact per-tile bake: each tile fetches the obstacles within maxDistance once and every texel takes the
+    // minimum over them. Tiles are shared between threadCount workers (0 - one per hardware thread)
+    void bake(const Maze& maze, const glm::vec2& boxMin, const glm::vec2& boxMax, int resolution,
+              float maxDistance, unsigned int threadCount = 0);
+    void clear();
+
+    bool isBaked() const { return !values.empty(); }
+
+    const std::vector<float>& getValues() const { return values; }
+    int getResolution() const { return resolution; }
+    float getTexel() const { return texel; }
+    glm::vec2 getBoxMin() const { return boxMin; }
+    glm::vec2 getBoxMax() const { return boxMax; }
+    float getMaxDistance() const { return maxDistance; }
+    size_t memoryUsage() const { return values.capacity() * sizeof(float); }
+
+private:
+    int resolution;
+    glm::vec2 boxMin;
+    glm::vec2 boxMax;
+    float texel;
+    float maxDistance;
+    std::vector<float> values; // row by row from boxMin, texel centers at boxMin + (k + 0.5) * texel
+
+    void bakeTile(const Maze& maze, int tileX, int tileY);
+};
+
+#endif
@@ -0,0 +1,987 @@
+#include "FlowField.hpp"
+#include "Maze.hpp"
+#include "Player.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <memory>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FLOW_FIELD_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+const float PI = 3.14159265358979323846f;
+const int sub = FlowField::subdivisions;
+const int angles = FlowField::angleCount;
+const int side = sub + 1;            // samples along a room edge, both corners included
+const int roomSamples = side * side;
+
+// bit a - angle a * PI / angleCount
+typedef uint16_t AngleMask;
+static_assert(FlowField::angleCount <= 16, "angle sets are 16-bit masks");
+const AngleMask allAngles = static_cast<AngleMask>((1u << angles) - 1);
+const uint16_t noLabel = 0xFFFF;
+
+const uint32_t noId = 0xFFFFFFFFu;
+
+// bit a of the result is bit a + 1 of the mask, angle PI being angle 0 again
+AngleMask nextAngles(AngleMask mask) {
+    return static_cast<AngleMask>(((mask >> 1) | (mask << (angles - 1))) & allAngles);
+}
+
+// bit a of the result is bit a - 1 of the mask
+AngleMask previousAngles(AngleMask mask) {
+    return static_cast<AngleMask>(((mask << 1) | (mask >> (angles - 1))) & allAngles);
+}
+
+int popcount(AngleMask mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcount(mask);
+#else
+    int count = 0;
+    for (; mask; mask &= mask - 1) count++;
+    return count;
+#endif
+}
+
+// Index of the lowest set bit of a nonzero mask
+int lowestBit(AngleMask mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(mask);
+#else
+    int index = 0;
+    for (; !(mask & 1u); mask >>= 1) index++;
+    return index;
+#endif
+}
+
+// The mask turned so bit 0 of the result is bit a of the mask, and back
+AngleMask rotateDown(AngleMask mask, int a) {
+    return static_cast<AngleMask>(((mask >> a) | (mask << (angles - a))) & allAngles);
+}
+
+AngleMask rotateUp(AngleMask mask, int a) {
+    return static_cast<AngleMask>(((mask << a) | (mask >> (angles - a))) & allAngles);
+}
+
+float cross(const glm::vec2& a, const glm::vec2& b) {
+    return a.x * b.y - a.y * b.x;
+}
+
+// The two generators of a rhombus turned by angle: its vertices are the four sums +-g0 +-g1
+void rhombusGenerators(float angle, float longHalf, float shortHalf, glm::vec2* generators) {
+    glm::vec2 along(-std::sin(angle), std::cos(angle));
+    glm::vec2 across(std::cos(angle), std::sin(angle));
+    generators[0] = (along * longHalf + across * shortHalf) * 0.5f;
+    generators[1] = (along * longHalf - across * shortHalf) * 0.5f;
+}
+
+// Andrew's monotone chain, counter-clockwise without collinear points
+int convexHull(glm::vec2* points, int count, glm::vec2* hull) {
+    std::sort(points, points + count, [](const glm::vec2& a, const glm::vec2& b) {
+        return a.x < b.x || (a.x == b.x && a.y < b.y);
+    });
+    int n = 0;
+    for (int i = 0; i < count; i++) {
+        while (n >= 2 && cross(hull[n - 1] - hull[n - 2], points[i] - hull[n - 2]) <= 1e-6f) n--;
+        hull[n++] = points[i];
+    }
+    for (int i = count - 2, lower = n + 1; i >= 0; i--) {
+        while (n >= lower && cross(hull[n - 1] - hull[n - 2], points[i] - hull[n - 2]) <= 1e-6f) n--;
+        hull[n++] = points[i];
+    }
+    return n - 1; // the first point closes the loop
+}
+
+// Generators of the player at every sampled angle and of the area it sweeps turning to the next one: the convex
+// hull of both poses grown by 1 / cos^2(half the turn), which holds the arcs the vertices travel on
+struct PlayerShapes {
+    glm::vec2 pose[angles][2];
+    glm::vec2 turn[angles][4];
+    int turnCount[angles];
+    int reach; // rows from an obstacle's center its regions can reach
+
+    PlayerShapes(float longHalf, float shortHalf) {
+        for (int a = 0; a < angles; a++) {
+            rhombusGenerators(a * PI / angles, longHalf, shortHalf, pose[a]);
+        }
+        const float half = 0.5f * PI / angles;
+        const float grow = 1.0f / (std::cos(half) * std::cos(half));
+        for (int a = 0; a < angles; a++) {
+            const glm::vec2* next = pose[(a + 1) % angles];
+            glm::vec2 points[8];
+            const glm::vec2* both[2] = { pose[a], next };
+            for (int r = 0; r < 2; r++) {
+                points[4 * r + 0] = both[r][0] + both[r][1];
+                points[4 * r + 1] = both[r][0] - both[r][1];
+                points[4 * r + 2] = -points[4 * r + 0];
+                points[4 * r + 3] = -points[4 * r + 1];
+            }
+            glm::vec2 hull[9];
+            int hullCount = convexHull(points, 8, hull);
+            int halfCount = hullCount / 2;
+            bool symmetric = hullCount % 2 == 0 && halfCount <= 4;
+            for (int v = 0; v < halfCount && symmetric; v++) {
+                symmetric = glm::length(hull[v] + hull[v + halfCount]) < 1e-4f * longHalf;
+            }
+            if (symmetric) {
+                turnCount[a] = halfCount;
+                for (int v = 0; v < halfCount; v++) turn[a][v] = (hull[v + 1] - hull[v]) * (0.5f * grow);
+            } else {
+                // the sum of both poses holds their hull too, only looser
+                turnCount[a] = 4;
+                turn[a][0] = pose[a][0] * grow;
+                turn[a][1] = pose[a][1] * grow;
+                turn[a][2] = next[0] * grow;
+                turn[a][3] = next[1] * grow;
+            }
+        }
+        // an obstacle and the player reach at most longHalf each, a move one sample more
+        reach = static_cast<int>(std::ceil(longHalf * (1.0f + grow))) + 1;
+    }
+};
+
+// What one sample blocks, per angle: the pose, a move to the sample at +x, +y, +x+y or +x-y, the turn to the
+// next angle. A move or turn is blocked when any pose along it (both ends included) overlaps an obstacle.
+// A row of samples keeps each sample's masks of all regions side by side
+enum Region { Pose, MoveX, MoveY, MoveRise, MoveFall, Turn, regionCount };
+
+const int maxSlabs = 6;
+const float unbounded = 1e6f;
+
+// The regions of one obstacle in configuration space, for every player angle side by side. Each is a centrally
+// symmetric polygon - the obstacle grown by the player (and by the move's segment or the turn's sweep) - given
+// as the slabs of its generators: in row y, relative to the obstacle's center in samples, slab s lets through
+// x in (start + slope * y, start + width + slope * y). The loops over the angles vectorize
+struct ObstacleRegions {
+    float start[regionCount][maxSlabs][angles];
+    float width[regionCount][maxSlabs][angles];
+    float slope[regionCount][maxSlabs][angles];
+    float rowMin[regionCount][angles];
+    float rowMax[regionCount][angles];
+    int slabCount[regionCount];
+    int firstRow[regionCount];
+    int lastRow[regionCount];
+    float margin; // every slab and row range grown by this many samples
+
+    // Slab of generator g whose half-width is halfWidth (both scaled by the normal's length)
+    void setSlab(int region, int slab, int a, const glm::vec2& g, float halfWidth, const glm::vec2& center) {
+        if (std::fabs(g.y) < 1e-6f) {
+            // parallel to the rows, the same bound as the region's row range
+            start[region][slab][a] = -unbounded;
+            width[region][slab][a] = 2.0f * unbounded;
+            slope[region][slab][a] = 0.0f;
+            return;
+        }
+        halfWidth += margin * glm::length(g);
+        float inverse = 1.0f / std::fabs(g.y);
+        slope[region][slab][a] = g.x / g.y;
+        start[region][slab][a] = center.x - halfWidth * inverse - slope[region][slab][a] * center.y;
+        width[region][slab][a] = 2.0f * halfWidth * inverse;
+    }
+
+    // halfWidths (if given) receives the slabs' half-widths before the margin
+    void setZonotope(int region, int a, const glm::vec2* generators, int count, const glm::vec2& center,
+                     float* halfWidths = nullptr) {
+        float extent = 0.0f;
+        for (int k = 0; k < count; k++) {
+            float halfWidth = 0.0f;
+            for (int i = 0; i < count; i++) halfWidth += std::fabs(cross(generators[k], generators[i]));
+            setSlab(region, k, a, generators[k], halfWidth, center);
+            extent += std::fabs(generators[k].y);
+            if (halfWidths) halfWidths[k] = halfWidth;
+        }
+        for (int k = count; k < slabCount[region]; k++) setSlab(region, k, a, glm::vec2(1.0f, 0.0f), 0.0f, center);
+        rowMin[region][a] = center.y - extent - margin;
+        rowMax[region][a] = center.y + extent + margin;
+    }
+
+    // MoveX needs no slabs of its own: its rows are the pose's, each reaching one sample further left
+    ObstacleRegions(const PlayerShapes& shapes, const glm::vec2* obstacle, float margin) : margin(margin) {
+        static const glm::vec2 moves[regionCount] = { glm::vec2(0.0f), glm::vec2(1.0f, 0.0f), glm::vec2(0.0f, 1.0f),
+                                                       glm::vec2(1.0f, 1.0f), glm::vec2(1.0f, -1.0f) };
+        slabCount[Pose] = 4;
+        slabCount[MoveX] = 0;
+        for (int region = MoveY; region <= MoveFall; region++) slabCount[region] = 5;
+        slabCount[Turn] = maxSlabs;
+        for (int a = 0; a < angles; a++) {
+            glm::vec2 generators[maxSlabs] = { obstacle[0], obstacle[1], shapes.pose[a][0], shapes.pose[a][1] };
+            float poseHalfWidths[4];
+            setZonotope(Pose, a, generators, 4, glm::vec2(0.0f), poseHalfWidths);
+            rowMin[MoveX][a] = rowMin[Pose][a];
+            rowMax[MoveX][a] = rowMax[Pose][a];
+            // the segment from the sample back to where the move ends grows the pose region into the positions
+            // whose move passes through the obstacle. Its slabs are the pose's, widened by the segment
+            for (int region = MoveY; region <= MoveFall; region++) {
+                glm::vec2 segment = moves[region] * 0.5f, center = moves[region] * -0.5f;
+                float segmentHalfWidth = 0.0f;
+                for (int k = 0; k < 4; k++) {
+                    float widening = std::fabs(cross(generators[k], segment));
+                    setSlab(region, k, a, generators[k], poseHalfWidths[k] + widening, center);
+                    segmentHalfWidth += widening;
+                }
+                setSlab(region, 4, a, segment, segmentHalfWidth, center);
+                rowMin[region][a] = center.y + rowMin[Pose][a] - std::fabs(segment.y);
+                rowMax[region][a] = center.y + rowMax[Pose][a] + std::fabs(segment.y);
+            }
+            for (int g = 0; g < shapes.turnCount[a]; g++) generators[2 + g] = shapes.turn[a][g];
+            setZonotope(Turn, a, generators, 2 + shapes.turnCount[a], glm::vec2(0.0f));
+        }
+        for (int region = 0; region < regionCount; region++) {
+            float low = 0.0f, high = 0.0f;
+            for (int a = 0; a < angles; a++) {
+                low = std::min(low, rowMin[region][a]);
+                high = std::max(high, rowMax[region][a]);
+            }
+            firstRow[region] = static_cast<int>(std::floor(low)) + 1;
+            lastRow[region] = static_cast<int>(std::ceil(high)) - 1;
+        }
+    }
+
+    // Whole samples [first, last] of row y inside the region, per angle (first > last when none)
+    void rowSpans(int region, int y, int16_t* first, int16_t* last) const {
+        const float row = static_cast<float>(y);
+        float lo[angles], hi[angles];
+        for (int a = 0; a < angles; a++) {
+            lo[a] = -unbounded;
+            hi[a] = unbounded;
+        }
+        for (int s = 0; s < slabCount[region]; s++) {
+            for (int a = 0; a < angles; a++) {
+                float bound = start[region][s][a] + slope[region][s][a] * row;
+                lo[a] = std::max(lo[a], bound);
+                hi[a] = std::min(hi[a], bound + width[region][s][a]);
+            }
+        }
+        // spans stay within reach of the center, so the shift keeps the truncation a floor. A row outside the
+        // region's range gets a first sample past its last
+        for (int a = 0; a < angles; a++) {
+            float outside = static_cast<float>((row <= rowMin[region][a]) | (row >= rowMax[region][a]));
+            first[a] = static_cast<int16_t>(static_cast<int>(lo[a] + outside * 512.0f + 256.0f) - 255);
+            last[a] = static_cast<int16_t>(255 - static_cast<int>(256.0f - hi[a]));
+        }
+    }
+};
+
+// Marks one region of a row: the mask of sample u (regionCount apart) gets bit a where first[a] <= u <= last[a]
+void markRow(AngleMask* row, int uLo, int uHi, const int16_t* first, const int16_t* last) {
+#ifdef FLOW_FIELD_SSE2
+    __m128i first0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+    __m128i first1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first + 8));
+    __m128i last0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(last));
+    __m128i last1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(last + 8));
+    for (int u = uLo; u <= uHi; u++) {
+        __m128i at = _mm_set1_epi16(static_cast<short>(u));
+        // outside where first > u or u > last, one byte per angle after the pack
+        __m128i out0 = _mm_or_si128(_mm_cmpgt_epi16(first0, at), _mm_cmpgt_epi16(at, last0));
+        __m128i out1 = _mm_or_si128(_mm_cmpgt_epi16(first1, at), _mm_cmpgt_epi16(at, last1));
+        row[u * regionCount] |= static_cast<AngleMask>(~_mm_movemask_epi8(_mm_packs_epi16(out0, out1)));
+    }
+#else
+    for (int u = uLo; u <= uHi; u++) {
+        AngleMask mask = 0;
+        for (int a = 0; a < angles; a++) mask |= static_cast<AngleMask>((first[a] <= u && u <= last[a]) << a);
+        row[u * regionCount] |= mask;
+    }
+#endif
+}
+
+// Marks one obstacle, centered on sample (cu, cv), into the rows [rowLo, rowHi] of the ring of rows
+void rasterizeObstacle(const ObstacleRegions& regions, int cu, int cv, int rowLo, int rowHi, int width,
+                       AngleMask* ring, int ringRows) {
+    static_assert(angles == 16, "rows are marked 16 angles at a time");
+    int16_t first[angles], last[angles];
+    for (int region = 0; region < regionCount; region++) {
+        if (region == MoveX) continue;
+        int yLo = std::max(regions.firstRow[region], rowLo - cv);
+        int yHi = std::min(regions.lastRow[region], rowHi - cv);
+        for (int y = yLo; y <= yHi; y++) {
+            regions.rowSpans(region, y, first, last);
+            int uLo = std::max(-cu, static_cast<int>(*std::min_element(first, first + angles)));
+            int uHi = std::min(width - 1 - cu, static_cast<int>(*std::max_element(last, last + angles)));
+            AngleMask* row = ring + (static_cast<size_t>((cv + y) % ringRows) * width + cu) * regionCount + region;
+            markRow(row, uLo, uHi, first, last);
+            if (region == Pose) {
+                for (int a = 0; a < angles; a++) first[a]--;
+                markRow(row + (MoveX - Pose), std::max(-cu, uLo - 1), uHi, first, last);
+            }
+        }
+    }
+}
+
+// Obstacles rasterized once per bin of their angle, every obstacle then only ORs its bin's stamp into the rows.
+// A stamp holds every angle of its bin: the regions are grown by the furthest an obstacle's vertex moves within
+// half a bin, so it may block a little more than the obstacle itself but never less
+struct StampTable {
+    static const int bins = 1024;
+    int radius;          // rows and samples a stamp reaches from the obstacle's center
+    int size;            // 2 * radius + 1
+    size_t stampSize;    // size rows of size * regionCount masks, laid out like the ring's rows
+    std::vector<int32_t> slots; // per bin, index of its stamp or -1 when no obstacle uses it
+    std::vector<int> used;      // per stamp, its bin
+    std::vector<AngleMask> masks;
+    const PlayerShapes* shapes;
+    float longHalf, shortHalf;
+
+    static int binOf(float angle) {
+        // the rhombus looks the same turned by PI
+        int bin = static_cast<int>(std::fmod(angle, PI) * (bins / PI));
+        return std::min(std::max(bin, 0), bins - 1);
+    }
+
+    // Picks the bins one of the maze's obstacles falls in and makes room for their stamps
+    void prepare(const Maze& maze, const PlayerShapes& shapes, float longHalf, float shortHalf) {
+        this->shapes = &shapes;
+        this->longHalf = longHalf;
+        this->shortHalf = shortHalf;
+        radius = shapes.reach + 1;
+        size = 2 * radius + 1;
+        stampSize = static_cast<size_t>(size) * regionCount * size;
+        const int gridN = maze.getGridN();
+        const ObstacleGrid& grid = maze.getGrid();
+        slots.assign(bins, -1);
+        used.clear();
+        if (static_cast<long long>(gridN) * gridN < 4LL * bins) {
+            for (int j = 0; j < gridN; j++) {
+                for (int i = 0; i < gridN; i++) {
+                    if (grid.isEmptyCell(i, j)) continue;
+                    int bin = binOf(maze.obstacleAngle(i, j));
+                    if (slots[bin] < 0) {
+                        slots[bin] = static_cast<int32_t>(used.size());
+                        used.push_back(bin);
+                    }
+                }
+            }
+        } else {
+            // large mazes use every bin, no need to look
+            for (int bin = 0; bin < bins; bin++) {
+                slots[bin] = bin;
+                used.push_back(bin);
+            }
+        }
+        masks.assign(used.size() * stampSize, AngleMask(0));
+    }
+
+    size_t stampCount() const { return used.size(); }
+
+    // Rasterizes stamp k, any thread can take any stamp
+    void rasterize(size_t k) {
+        glm::vec2 obstacle[2];
+        rhombusGenerators((used[k] + 0.5f) * (PI / bins), longHalf, shortHalf, obstacle);
+        ObstacleRegions regions(*shapes, obstacle, longHalf * (0.5f * PI / bins));
+        rasterizeObstacle(regions, radius, radius, 0, size - 1, size, masks.data() + k * stampSize, size);
+    }
+
+    // ORs the stamp of an obstacle at the given angle, centered on sample (cu, cv), into the rows
+    // [rowLo, rowHi] of the ring of rows
+    void mark(float angle, int cu, int cv, int rowLo, int rowHi, int width, AngleMask* ring, int ringRows) const {
+        const AngleMask* stamp = masks.data() + static_cast<size_t>(slots[binOf(angle)]) * stampSize;
+        int uLo = std::max(-radius, -cu), uHi = std::min(radius, width - 1 - cu);
+        int yLo = std::max(-radius, rowLo - cv), yHi = std::min(radius, rowHi - cv);
+        const int count = (uHi - uLo + 1) * regionCount;
+        for (int y = yLo; y <= yHi; y++) {
+            AngleMask* row = ring + (static_cast<size_t>((cv + y) % ringRows) * width + cu + uLo) * regionCount;
+            const AngleMask* from = stamp + (static_cast<size_t>(y + radius) * size + radius + uLo) * regionCount;
+            int k = 0;
+#ifdef FLOW_FIELD_SSE2
+            for (; k + 8 <= count; k += 8) {
+                __m128i* to = reinterpret_cast<__m128i*>(row + k);
+                _mm_storeu_si128(to, _mm_or_si128(_mm_loadu_si128(to),
+                                                  _mm_loadu_si128(reinterpret_cast<const __m128i*>(from + k))));
+            }
+#endif
+            for (; k < count; k++) row[k] |= from[k];
+        }
+    }
+};
+
+// Union-find over the pieces of free configuration space, roots are the smallest id of their set
+struct DisjointSets {
+    std::vector<uint32_t> parent;
+
+    uint32_t add(uint32_t count) {
+        uint32_t first = static_cast<uint32_t>(parent.size());
+        for (uint32_t k = 0; k < count; k++) parent.push_back(first + k);
+        return first;
+    }
+    uint32_t find(uint32_t x) {
+        while (parent[x] != x) {
+            parent[x] = parent[parent[x]];
+            x = parent[x];
+        }
+        return x;
+    }
+    void unite(uint32_t a, uint32_t b) {
+        a = find(a);
+        b = find(b);
+        if (a < b) parent[b] = a;
+        else if (b < a) parent[a] = b;
+    }
+};
+
+// Connected pieces of one room's free poses. Angles a sample can turn between freely form a run, the runs of
+// neighbouring samples are joined where a move keeps a shared angle clear all the way. Runs are numbered in
+// sample order and joined by a small union-find as they come, with the runs of the samples before
+struct RoomSolver {
+    AngleMask blocked[roomSamples][regionCount];
+    AngleMask free[roomSamples];
+    AngleMask runs[roomSamples * angles];
+    uint16_t firstRun[roomSamples + 1]; // runs of sample p are [firstRun[p], firstRun[p + 1])
+    uint16_t parent[roomSamples * angles];
+    uint16_t labels[roomSamples * angles];
+
+    // Fills the pieces of the room whose corner is sample x of the rows, returns how many there are
+    int solve(const AngleMask* const* rows, int x) {
+        int runCount = 0;
+        for (int v = 0; v < side; v++) {
+            const AngleMask* row = rows[v] + static_cast<size_t>(x) * regionCount;
+            std::copy(row, row + side * regionCount, blocked[v * side]);
+            for (int u = 0; u < side; u++) {
+                int p = v * side + u;
+                firstRun[p] = static_cast<uint16_t>(runCount);
+                free[p] = static_cast<AngleMask>(~blocked[p][Pose] & allAngles);
+                if (!free[p]) continue;
+                int first = runCount;
+                runCount = splitRuns(p, runCount);
+                firstRun[p + 1] = static_cast<uint16_t>(runCount);
+                for (int r = first; r < runCount; r++) parent[r] = static_cast<uint16_t>(r);
+                // the moves that end here from the samples already split: from the left and from below
+                if (runCount == first + 1) {
+                    // one run, by far the most common: its root is kept at hand
+                    int root = first;
+                    if (u > 0) joinOne(p - 1, first, root, blocked[p - 1][MoveX]);
+                    if (v > 0) {
+                        joinOne(p - side, first, root, blocked[p - side][MoveY]);
+                        if (u > 0) joinOne(p - side - 1, first, root, blocked[p - side - 1][MoveRise]);
+                        if (u < sub) joinOne(p - side + 1, first, root, blocked[p][MoveFall]);
+                    }
+                    continue;
+                }
+                if (u > 0) join(p - 1, p, blocked[p - 1][MoveX]);
+                if (v > 0) {
+                    join(p - side, p, blocked[p - side][MoveY]);
+                    if (u > 0) join(p - side - 1, p, blocked[p - side - 1][MoveRise]);
+                    if (u < sub) join(p - side + 1, p, blocked[p][MoveFall]);
+                }
+            }
+        }
+        firstRun[roomSamples] = static_cast<uint16_t>(runCount);
+
+        int count = 0;
+        for (int r = 0; r < runCount; r++) {
+            int root = find(r);
+            labels[r] = root == r ? static_cast<uint16_t>(count++) : labels[root];
+        }
+        return count;
+    }
+
+    // Piece of sample p at angle a, noLabel where the pose collides
+    uint16_t pieceAt(int p, int a) const {
+        for (int r = firstRun[p]; r < firstRun[p + 1]; r++) {
+            if (runs[r] >> a & 1u) return labels[r];
+        }
+        return noLabel;
+    }
+
+private:
+    int splitRuns(int p, int runCount) {
+        AngleMask f = free[p];
+        // bit a - the turn from angle a to a + 1 stays clear (its region holds both poses)
+        AngleMask joined = static_cast<AngleMask>(~blocked[p][Turn] & f & nextAngles(f));
+        AngleMask starts = static_cast<AngleMask>(f & ~previousAngles(joined));
+        if (!(starts & (starts - 1))) {
+            // all the way round, or from the one start through every free angle
+            runs[runCount] = f;
+            return runCount + 1;
+        }
+        for (; starts; starts &= starts - 1) {
+            // the run goes on from its start while the turns are joined, through the first angle that is not
+            int a = lowestBit(starts);
+            unsigned following = rotateDown(joined, a);
+            unsigned firstUnjoined = ~following & (following + 1);
+            runs[runCount++] = rotateUp(static_cast<AngleMask>((firstUnjoined << 1) - 1), a);
+        }
+        return runCount;
+    }
+
+    // roots stay the lowest run of their set, so the labels come out in sample order
+    int find(int r) {
+        while (parent[r] != r) {
+            parent[r] = parent[parent[r]];
+            r = parent[r];
+        }
+        return r;
+    }
+
+    void unite(int r, int t) {
+        int a = find(r), b = find(t);
+        if (a < b) parent[b] = static_cast<uint16_t>(a);
+        else if (b < a) parent[a] = static_cast<uint16_t>(b);
+    }
+
+    // Joins run r, whose set has the given root, with the runs of the earlier sample q it shares an angle the
+    // move between keeps clear, keeping the root up to date
+    void joinOne(int q, int r, int& root, AngleMask moveBlocked) {
+        AngleMask shared = static_cast<AngleMask>(runs[r] & ~moveBlocked);
+        for (int t = firstRun[q]; t < firstRun[q + 1]; t++) {
+            if (!(runs[t] & shared)) continue;
+            int a = find(t);
+            int low = std::min(a, root);
+            parent[std::max(a, root)] = static_cast<uint16_t>(low); // a root onto itself when they are one set
+            root = low;
+        }
+    }
+
+    // Same for every run of sample p
+    void join(int q, int p, AngleMask moveBlocked) {
+        AngleMask clear = static_cast<AngleMask>(~moveBlocked);
+        for (int t = firstRun[q]; t < firstRun[q + 1]; t++) {
+            AngleMask shared = static_cast<AngleMask>(runs[t] & clear);
+            if (!shared) continue;
+            for (int r = firstRun[p]; r < firstRun[p + 1]; r++) {
+                if (runs[r] & shared) unite(t, r);
+            }
+        }
+    }
+};
+
+// Pieces of the runs along one room edge, sample after sample. The rooms on both sides of an edge split its
+// samples into the same runs, so their lists line up
+struct EdgeRuns {
+    uint32_t ids[side * angles / 2]; // a sample has at most angles / 2 runs
+    int count = 0;
+};
+
+const uint8_t reachesX = 1; // the piece has poses on its room's +x edge
+const uint8_t reachesY = 2; // on the +y edge
+
+// The rooms of bands [firstBand, endBand) solved on one thread, ids local to the chunk
+struct Chunk {
+    int firstBand, endBand;
+    DisjointSets sets;
+    std::vector<uint8_t> reaches;      // per piece, reachesX | reachesY
+    std::vector<EdgeRuns> firstBottom; // along the bottom edge of the first band, per room
+    std::vector<EdgeRuns> lastTop;     // along the top edge of the last band
+    uint32_t startId = noId;
+    std::vector<uint32_t> goalIds;
+    int mostPieces = 0;
+};
+
+// Per room, for joining the chunks and walking the rooms afterwards
+struct RoomPieces {
+    std::vector<uint32_t> base;       // id of the room's piece 0
+    std::vector<uint16_t> pieceCount;
+    std::vector<uint8_t> crossingX;   // sample along the room's +x edge where the way through is widest
+    std::vector<uint8_t> crossingY;   // same for the +y edge
+};
+
+// Joins the ids of one edge's runs with the ids the neighbouring room left there, skipping repeated pairs
+void uniteEdge(DisjointSets& sets, const EdgeRuns& theirs, const EdgeRuns& ours, uint32_t theirOffset = 0,
+               uint32_t ourOffset = 0) {
+    uint32_t lastTheirs = noId, lastOurs = noId;
+    for (int k = 0; k < std::min(theirs.count, ours.count); k++) {
+        if (theirs.ids[k] == lastTheirs && ours.ids[k] == lastOurs) continue;
+        lastTheirs = theirs.ids[k];
+        lastOurs = ours.ids[k];
+        sets.unite(lastTheirs + theirOffset, lastOurs + ourOffset);
+    }
+}
+
+// Whole lattice width of one band at a time, its rooms solved left to right. Obstacle rows are stamped once
+// into a ring of sample rows, as soon as the first band they reach comes up
+void solveChunk(const Maze& maze, const StampTable& stamps, int rooms, Chunk& chunk, RoomPieces& pieces,
+                const std::atomic<bool>& cancelled) {
+    const ObstacleGrid& grid = maze.getGrid();
+    const int gridN = maze.getGridN();
+    const int width = rooms * sub + 1;
+    const int lastSampleRow = rooms * sub;
+
+    // live rows: the band's own and the ones obstacles already stamped reach above it
+    const int ringRows = side + 2 * stamps.radius + sub;
+    const size_t rowSize = static_cast<size_t>(regionCount) * width;
+    std::vector<AngleMask> ring(ringRows * rowSize);
+    int nextObstacleRow = std::max(0, chunk.firstBand - (stamps.radius + sub - 1) / sub);
+    int clearedTo = chunk.firstBand * sub; // rows below are never read
+
+    std::vector<EdgeRuns> belowTop(rooms), aboveTop(rooms);
+    EdgeRuns leftRight, edge;
+    RoomSolver solver;
+    chunk.firstBottom.resize(rooms);
+
+    float startAngle = std::fmod(Player().getAngle(), PI);
+    if (startAngle < 0.0f) startAngle += PI;
+    int startBit = static_cast<int>(std::lround(startAngle / (PI / angles))) % angles;
+
+    for (int j = chunk.firstBand; j < chunk.endBand; j++) {
+        if (cancelled.load(std::memory_order_relaxed)) return;
+        const int bandRow = j * sub;
+
+        // --- obstacle rows that reach the band, on top of the ones stamped for the bands below ---
+        int needed = std::min(gridN - 1, (bandRow + sub + stamps.radius) / sub);
+        for (; nextObstacleRow <= needed; nextObstacleRow++) {
+            int reachTo = std::min(lastSampleRow, nextObstacleRow * sub + stamps.radius);
+            for (; clearedTo <= reachTo; clearedTo++) {
+                std::fill_n(ring.begin() + (clearedTo % ringRows) * rowSize, rowSize, AngleMask(0));
+            }
+            for (int oi = 0; oi < gridN; oi++) {
+                if (grid.isEmptyCell(oi, nextObstacleRow)) continue;
+                stamps.mark(maze.obstacleAngle(oi, nextObstacleRow), oi * sub, nextObstacleRow * sub, bandRow, reachTo,
+                            width, ring.data(), ringRows);
+            }
+        }
+        for (; clearedTo <= bandRow + sub; clearedTo++) {
+            std::fill_n(ring.begin() + (clearedTo % ringRows) * rowSize, rowSize, AngleMask(0));
+        }
+        const AngleMask* rows[side];
+        for (int v = 0; v < side; v++) rows[v] = ring.data() + ((bandRow + v) % ringRows) * rowSize;
+
+        // --- rooms, joined with the one on the left and the one below ---
+        belowTop.swap(aboveTop);
+        for (int i = 0; i < rooms; i++) {
+            size_t room = static_cast<size_t>(j) * rooms + i;
+            int count = solver.solve(rows, i * sub);
+            uint32_t base = chunk.sets.add(static_cast<uint32_t>(count));
+            chunk.reaches.resize(chunk.sets.parent.size(), 0);
+            chunk.mostPieces = std::max(chunk.mostPieces, count);
+            pieces.base[room] = base;
+            pieces.pieceCount[room] = static_cast<uint16_t>(count);
+
+            // ids of the runs along one edge, samples stride apart from p, whose pieces get the given bit
+            auto edgeRuns = [&](int p, int stride, EdgeRuns& runs, uint8_t bit) {
+                runs.count = 0;
+                for (int e = 0; e < side; e++, p += stride) {
+                    for (int r = solver.firstRun[p]; r < solver.firstRun[p + 1]; r++) {
+                        uint32_t id = base + solver.labels[r];
+                        runs.ids[runs.count++] = id;
+                        chunk.reaches[id] |= bit;
+                    }
+                }
+            };
+            edgeRuns(0, side, edge, 0);
+            if (i > 0) uniteEdge(chunk.sets, leftRight, edge);
+            if (j == chunk.firstBand) {
+                edgeRuns(0, 1, chunk.firstBottom[i], 0);
+            } else {
+                edgeRuns(0, 1, edge, 0);
+                uniteEdge(chunk.sets, belowTop[i], edge);
+            }
+            edgeRuns(sub, side, leftRight, reachesX);
+            edgeRuns(sub * side, 1, aboveTop[i], reachesY);
+
+            // the crossing is the edge sample with the most free angles, the middle one on a tie
+            int bestX = sub / 2, bestY = sub / 2;
+            for (int e = 1; e < sub; e++) {
+                auto better = [&](int candidate, int best, int p, int bestP) {
+                    int freeCandidate = popcount(solver.free[p]), freeBest = popcount(solver.free[bestP]);
+                    if (freeCandidate != freeBest) return freeCandidate > freeBest;
+                    return std::abs(2 * candidate - sub) < std::abs(2 * best - sub);
+                };
+                if (better(e, bestX, e * side + sub, bestX * side + sub)) bestX = e;
+                if (better(e, bestY, sub * side + e, sub * side + bestY)) bestY = e;
+            }
+            pieces.crossingX[room] = static_cast<uint8_t>(bestX);
+            pieces.crossingY[room] = static_cast<uint8_t>(bestY);
+
+            if (room == 0) {
+                uint16_t label = solver.pieceAt(0, startBit);
+                if (label != noLabel) chunk.startId = base + label;
+            }
+            if (i == rooms - 1 && j == rooms - 1) {
+                for (int r = solver.firstRun[roomSamples - 1]; r < solver.firstRun[roomSamples]; r++) {
+                    chunk.goalIds.push_back(base + solver.labels[r]);
+                }
+            }
+        }
+    }
+    chunk.lastTop.swap(aboveTop);
+}
+
+// Threads of one build meet here between its stages and between the levels of the wavefront
+class SpinBarrier {
+public:
+    explicit SpinBarrier(unsigned int count) : count(count), waiting(0), generation(0) {}
+
+    void wait() {
+        unsigned int current = generation.load(std::memory_order_acquire);
+        if (waiting.fetch_add(1, std::memory_order_acq_rel) + 1 == count) {
+            waiting.store(0, std::memory_order_relaxed);
+            generation.fetch_add(1, std::memory_order_release);
+            return;
+        }
+        while (generation.load(std::memory_order_acquire) == current) std::this_thread::yield();
+    }
+
+private:
+    const unsigned int count;
+    std::atomic<unsigned int> waiting;
+    std::atomic<unsigned int> generation;
+};
+
+// Share t of count of [0, total)
+size_t shareBegin(size_t total, unsigned int t, unsigned int count) {
+    return total * t / count;
+}
+
+}
+
+FlowField::FlowField()
+    : rooms(0), origin(0.0f), step(0.0f), solvable(false), buildMs(0.0), mostPieces(0), built(false),
+      cancelled(false) {
+}
+
+FlowField::~FlowField() {
+    cancelled.store(true, std::memory_order_relaxed);
+    wait();
+}
+
+void FlowField::build(const Maze& maze, unsigned int threadCount) {
+    wait();
+    run(maze, threadCount);
+}
+
+void FlowField::buildInBackground(const Maze& maze, unsigned int threadCount) {
+    wait();
+    built.store(false, std::memory_order_release);
+    worker = std::thread([this, &maze, threadCount]() { run(maze, threadCount); });
+}
+
+void FlowField::wait() {
+    if (worker.joinable()) worker.join();
+}
+
+void FlowField::run(const Maze& maze, unsigned int threadCount) {
+    auto start = std::chrono::steady_clock::now();
+    built.store(false, std::memory_order_release);
+    rooms = 0;
+    solvable = false;
+    mostPieces = 0;
+    distances.clear();
+    headings.clear();
+    if (maze.isImplicit() || maze.getGridN() < 2) return;
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    rooms = maze.getGridN() - 1;
+    step = maze.getStep();
+    origin = maze.getGrid().cellCenter(0, 0);
+    const size_t roomCount = static_cast<size_t>(rooms) * rooms;
+    const float spacing = step / sub;
+    const float longHalf = maze.getLongDiag() / 2.0f / spacing, shortHalf = maze.getShortDiag() / 2.0f / spacing;
+    const PlayerShapes shapes(longHalf, shortHalf);
+    StampTable stamps;
+    stamps.prepare(maze, shapes, longHalf, shortHalf);
+
+    RoomPieces pieces;
+    pieces.base.resize(roomCount);
+    pieces.pieceCount.resize(roomCount);
+    pieces.crossingX.resize(roomCount);
+    pieces.crossingY.resize(roomCount);
+
+    // One team of threads runs every stage, meeting at the barrier in between: the stamps, the rooms (contiguous
+    // bands per thread, each with its own ids), one id space, the open edges, the wavefront level by level and
+    // the direction grid. Thread 0 does the little there is to do alone between the stages
+    threadCount = std::min(threadCount, static_cast<unsigned int>(rooms));
+    std::vector<Chunk> chunks(threadCount);
+    for (unsigned int t = 0; t < threadCount; t++) {
+        chunks[t].firstBand = static_cast<int>(shareBegin(rooms, t, threadCount));
+        chunks[t].endBand = static_cast<int>(shareBegin(rooms, t + 1, threadCount));
+    }
+    SpinBarrier barrier(threadCount);
+    std::atomic<size_t> nextStamp(0);
+    bool stopped = false;
+
+    DisjointSets sets;
+    std::vector<uint8_t> reaches;
+    std::vector<uint32_t> offsets(threadCount);
+    uint32_t goalRoot = noId;
+    std::vector<uint8_t> openX, openY;  // the piece joined to the finish has poses on the room's +x, +y edge
+    std::unique_ptr<std::atomic<uint8_t>[]> claimed;
+    std::vector<uint32_t> frontier;
+    std::vector<std::vector<uint32_t>> found(threadCount);
+    bool wavefrontDone = false;
+
+    auto work = [&](unsigned int t) {
+        // --- stamps ---
+        for (size_t k = nextStamp++; k < stamps.stampCount(); k = nextStamp++) stamps.rasterize(k);
+        barrier.wait();
+
+        // --- rooms ---
+        solveChunk(maze, stamps, rooms, chunks[t], pieces, cancelled);
+        barrier.wait();
+
+        // --- one id space: chunks one after another, joined where their bands meet ---
+        if (t == 0) {
+            stopped = cancelled.load(std::memory_order_relaxed);
+            uint32_t total = 0;
+            for (unsigned int c = 0; c < threadCount; c++) {
+                offsets[c] = total;
+                total += static_cast<uint32_t>(chunks[c].sets.parent.size());
+                mostPieces = std::max(mostPieces, chunks[c].mostPieces);
+            }
+            if (!stopped) {
+                sets.parent.resize(total);
+                reaches.resize(total);
+            }
+        }
+        barrier.wait();
+        if (!stopped) {
+            const Chunk& chunk = chunks[t];
+            for (size_t k = 0; k < chunk.sets.parent.size(); k++) sets.parent[offsets[t] + k] = chunk.sets.parent[k] + offsets[t];
+            std::copy(chunk.reaches.begin(), chunk.reaches.end(), reaches.begin() + offsets[t]);
+            for (size_t room = static_cast<size_t>(chunk.firstBand) * rooms; room < static_cast<size_t>(chunk.endBand) * rooms; room++) {
+                pieces.base[room] += offsets[t];
+            }
+        }
+        barrier.wait();
+        if (t == 0 && !stopped) {
+            for (unsigned int c = 1; c < threadCount; c++) {
+                for (int i = 0; i < rooms; i++) {
+                    uniteEdge(sets, chunks[c - 1].lastTop[i], chunks[c].firstBottom[i], offsets[c - 1], offsets[c]);
+                }
+            }
+            uint32_t startId = chunks.front().startId, goalId = noId;
+            for (uint32_t id : chunks.back().goalIds) {
+                id += offsets.back();
+                if (goalId == noId) goalId = id;
+                else sets.unite(goalId, id);
+            }
+            // roots are the smallest id of their set, one pass in id order leaves every id pointing at its root
+            for (size_t id = 0; id < sets.parent.size(); id++) sets.parent[id] = sets.parent[sets.parent[id]];
+            goalRoot = goalId == noId ? noId : sets.parent[goalId];
+            solvable = startId != noId && goalId != noId && sets.parent[startId] == goalRoot;
+
+            distances.assign(roomCount, -1);
+            openX.assign(roomCount, 0);
+            openY.assign(roomCount, 0);
+            claimed.reset(new std::atomic<uint8_t>[roomCount]());
+            headings.assign(roomCount * directionCells * directionCells * 2, 0);
+            if (goalRoot != noId) {
+                distances[roomCount - 1] = 0;
+                claimed[roomCount - 1].store(1, std::memory_order_relaxed);
+                frontier.push_back(static_cast<uint32_t>(roomCount - 1));
+            }
+        }
+        barrier.wait();
+
+        // --- edges a piece joined to the finish reaches, rooms in equal shares ---
+        if (!stopped && goalRoot != noId) {
+            for (size_t room = shareBegin(roomCount, t, threadCount); room < shareBegin(roomCount, t + 1, threadCount); room++) {
+                uint8_t open = 0;
+                for (uint32_t id = pieces.base[room]; id < pieces.base[room] + pieces.pieceCount[room]; id++) {
+                    if (sets.parent[id] == goalRoot) open |= reaches[id];
+                }
+                openX[room] = room % rooms < static_cast<size_t>(rooms - 1) && (open & reachesX);
+                openY[room] = room / rooms < static_cast<size_t>(rooms - 1) && (open & reachesY);
+            }
+        }
+        barrier.wait();
+
+        // --- wavefront over the rooms from the finish, a share of each level's rooms per thread ---
+        for (int32_t level = 1; !stopped; level++) {
+            std::vector<uint32_t>& next = found[t];
+            // neighbour and whether the edge between is open
+            auto reach = [&](size_t neighbour, bool isOpen) {
+                if (!isOpen || claimed[neighbour].exchange(1, std::memory_order_relaxed)) return;
+                distances[neighbour] = level;
+                next.push_back(static_cast<uint32_t>(neighbour));
+            };
+            for (size_t k = shareBegin(frontier.size(), t, threadCount); k < shareBegin(frontier.size(), t + 1, threadCount); k++) {
+                size_t room = frontier[k];
+                size_t i = room % rooms;
+                if (i + 1 < static_cast<size_t>(rooms)) reach(room + 1, openX[room]);
+                if (i > 0) reach(room - 1, openX[room - 1]);
+                if (room + rooms < roomCount) reach(room + rooms, openY[room]);
+                if (room >= static_cast<size_t>(rooms)) reach(room - rooms, openY[room - rooms]);
+            }
+            barrier.wait();
+            if (t == 0) {
+                frontier.clear();
+                for (std::vector<uint32_t>& list : found) {
+                    frontier.insert(frontier.end(), list.begin(), list.end());
+                    list.clear();
+                }
+                wavefrontDone = frontier.empty() || cancelled.load(std::memory_order_relaxed);
+            }
+            barrier.wait();
+            if (wavefrontDone) break;
+        }
+
+        // --- direction grid, rows of rooms in equal shares: every cell heads for the crossing into the first
+        // open neighbour one room closer to the finish (+x, -x, +y, -y), the finish room's for the finish corner ---
+        if (stopped) return;
+        const int cellsPerSide = rooms * directionCells;
+        const int firstRow = static_cast<int>(shareBegin(rooms, t, threadCount));
+        const int endRow = static_cast<int>(shareBegin(rooms, t + 1, threadCount));
+        for (int j = firstRow; j < endRow; j++) {
+            for (int i = 0; i < rooms; i++) {
+                size_t room = static_cast<size_t>(j) * rooms + i;
+                int32_t closer = distances[room] - 1;
+                if (closer < -1) continue;
+                glm::vec2 target = glm::vec2(float(rooms)); // the finish corner, in rooms from the origin
+                if (closer < 0) {
+                    // the finish room
+                } else if (i + 1 < rooms && openX[room] && distances[room + 1] == closer) {
+                    target = glm::vec2(i + 1.0f, j + pieces.crossingX[room] / float(sub));
+                } else if (i > 0 && openX[room - 1] && distances[room - 1] == closer) {
+                    target = glm::vec2(float(i), j + pieces.crossingX[room - 1] / float(sub));
+                } else if (j + 1 < rooms && openY[room] && distances[room + rooms] == closer) {
+                    target = glm::vec2(i + pieces.crossingY[room] / float(sub), j + 1.0f);
+                } else {
+                    target = glm::vec2(i + pieces.crossingY[room - rooms] / float(sub), float(j));
+                }
+                for (int cj = j * directionCells; cj < (j + 1) * directionCells; cj++) {
+                    for (int ci = i * directionCells; ci < (i + 1) * directionCells; ci++) {
+                        // cell centers sit off the room's edges and corners, so the offset never vanishes
+                        glm::vec2 offset = target - (glm::vec2(float(ci), float(cj)) + 0.5f) / float(directionCells);
+                        offset *= 127.0f / glm::length(offset);
+                        int8_t* heading = headings.data() + (static_cast<size_t>(cj) * cellsPerSide + ci) * 2;
+                        heading[0] = static_cast<int8_t>(std::lround(offset.x));
+                        heading[1] = static_cast<int8_t>(std::lround(offset.y));
+                    }
+                }
+            }
+        }
+    };
+    std::vector<std::thread> team;
+    for (unsigned int t = 1; t < threadCount; t++) team.emplace_back(work, t);
+    work(0);
+    for (std::thread& member : team) member.join();
+    if (cancelled.load(std::memory_order_relaxed)) return;
+
+    buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    built.store(true, std::memory_order_release);
+}
+
+int FlowField::roomAt(const glm::vec2& p) const {
+    if (rooms == 0) return -1;
+    glm::vec2 cell = (p - origin) / step;
+    if (cell.x < 0.0f || cell.y < 0.0f || cell.x > rooms || cell.y > rooms) return -1;
+    int i = std::min(static_cast<int>(cell.x), rooms - 1);
+    int j = std::min(static_cast<int>(cell.y), rooms - 1);
+    return j * rooms + i;
+}
+
+glm::vec2 FlowField::directionAt(const glm::vec2& p) const {
+    if (!isBuilt() || rooms == 0) return glm::vec2(0.0f);
+    glm::vec2 cell = (p - origin) / step * float(directionCells);
+    const int cellsPerSide = rooms * directionCells;
+    if (cell.x < 0.0f || cell.y < 0.0f || cell.x > cellsPerSide || cell.y > cellsPerSide) return glm::vec2(0.0f);
+    int ci = std::min(static_cast<int>(cell.x), cellsPerSide - 1);
+    int cj = std::min(static_cast<int>(cell.y), cellsPerSide - 1);
+    const int8_t* heading = headings.data() + (static_cast<size_t>(cj) * cellsPerSide + ci) * 2;
+    if (heading[0] == 0 && heading[1] == 0) return glm::vec2(0.0f);
+    glm::vec2 direction(heading[0], heading[1]);
+    return direction / glm::length(direction);
+}
+
+int FlowField::distanceAt(const glm::vec2& p) const {
+    if (!isBuilt()) return -1;
+    int room = roomAt(p);
+    return room < 0 ? -1 : distances[room];
+}
+
+size_t FlowField::memoryUsage() const {
+    return distances.capacity() * sizeof(int32_t) + headings.capacity();
+}
@@ -0,0 +1,77 @@
+#ifndef FLOWFIELD_HPP
+#define FLOWFIELD_HPP
+
+#include <glm/glm.hpp>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+class Maze;
+
+// Navigation data of a stored maze. Configuration space is sampled every 1/subdivisions of a lattice step at
+// angleCount player angles over [0, PI) - the rhombus looks the same turned by PI. A pose collides when it lies
+// in an obstacle's configuration-space polygon (the obstacle grown by the player, a centrally symmetric octagon),
+// and a move between neighbouring samples - one of the eight translations or a turn to the next angle - counts
+// only when its whole sweep stays clear, so thin gaps between two samples cannot be cut through.
+// The lattice squares between four obstacle centers ("rooms") are solved one at a time: the connected pieces
+// of each room's free poses are joined with their neighbours' across the shared edges (union-find), which gives
+// the verdict, and a breadth-first wavefront over the rooms from the finish gives the distance and the way out
+// of every room, from which every cell of a finer direction grid takes its heading. Memory stays a dozen bytes
+// per room whatever the sampling. Only paths with the player's center inside the lattice square count (the game
+// itself does not fence the level in)
+class FlowField {
+public:
+    static const int subdivisions = 8;
+    static const int angleCount = 16;
+    static const int directionCells = 2; // cells of the direction grid along a room's side
+
+    FlowField();
+    // Stops a build still running in the background
+    ~FlowField();
+    FlowField(const FlowField&) = delete;
+    FlowField& operator=(const FlowField&) = delete;
+
+    // Every stage runs on one team of threadCount threads (0 - one per hardware thread): the rooms in bands of
+    // rows, the wavefront a share of each level's rooms per thread. Implicit mazes are skipped
+    void build(const Maze& maze, unsigned int threadCount = 0);
+    // Same on a thread of its own, isBuilt() turns true once the results are in. The maze must stay unchanged
+    // until then (or until wait() returns)
+    void buildInBackground(const Maze& maze, unsigned int threadCount = 0);
+    void wait();
+
+    bool isBuilt() const { return built.load(std::memory_order_acquire); }
+    // The player can get from its start pose to the finish
+    bool isSolvable() const { return isBuilt() && solvable; }
+    double getBuildMs() const { return isBuilt() ? buildMs : 0.0; }
+
+    // Unit step from p's cell of the direction grid towards the crossing that leads out of its room towards the
+    // finish, (0, 0) when it cannot reach the finish or the field is not built yet
+    glm::vec2 directionAt(const glm::vec2& p) const;
+    // Rooms between p's and the finish's, -1 when unreachable
+    int distanceAt(const glm::vec2& p) const;
+    // Most connected pieces of free poses found in one room
+    int getMostPieces() const { return isBuilt() ? mostPieces : 0; }
+
+    // Bytes of the distance and direction grids
+    size_t memoryUsage() const;
+
+private:
+    int rooms;             // rooms per side, GRID_N - 1
+    glm::vec2 origin;      // center of cell (0, 0), a corner of room (0, 0)
+    float step;            // lattice step, the side of a room
+    bool solvable;
+    double buildMs;
+    int mostPieces;
+    std::vector<int32_t> distances; // per room
+    std::vector<int8_t> headings;   // per direction cell, x and y of the unit step times 127, (0, 0) - none
+    std::atomic<bool> built;
+    std::atomic<bool> cancelled;
+    std::thread worker;
+
+    void run(const Maze& maze, unsigned int threadCount);
+    int roomAt(const glm::vec2& p) const;
+};
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef GEOMETRY2D_HPP
+#define GEOMETRY2D_HPP
+
+#include <glm/glm.hpp>
+
+inline float crossProduct(glm::vec2 a, glm::vec2 b) {
+    return a.x * b.y - a.y * b.x;
+}
+
+//https://stackoverflow.com/questions/563198/how-do-you-detect-where-two-line-segments-intersect
+inline bool segmentsIntersect(glm::vec2 p1, glm::vec2 p2, glm::vec2 q1, glm::vec2 q2) {
+    glm::vec2 v1 = p2 - p1; // vector of a segment p1-p2
+    glm::vec2 v2 = q2 - q1; // vector of a segment q1-q2
+    float v1Xv2 = crossProduct(v1, v2);
+    glm::vec2 pq = q1 - p1;
+
+    if (v1Xv2 == 0) return false; // parallel 
+
+    float t = crossProduct(pq, v2) / v1Xv2;
+    float u = crossProduct(pq, v1) / v1Xv2;
+
+    return (t >= 0 && t <= 1 && u >= 0 && u <= 1);
+}
+
+// Same test without the divisions: t = tNum / den lies in [0, 1] when tNum has the sign of den and is not larger.
+// Flipping both by the sign of den leaves plain comparisons. Scalar reference of the SegmentBatch kernels
+inline bool segmentsCross(glm::vec2 p1, glm::vec2 p2, glm::vec2 q1, glm::vec2 q2) {
+    glm::vec2 v1 = p2 - p1;
+    glm::vec2 v2 = q2 - q1;
+    glm::vec2 pq = q1 - p1;
+    float den = crossProduct(v1, v2);
+    float tNum = crossProduct(pq, v2);
+    float uNum = crossProduct(pq, v1);
+    if (den < 0) {
+        den = -den;
+        tNum = -tNum;
+        uNum = -uNum;
+    }
+    return den > 0 && tNum >= 0 && tNum <= den && uNum >= 0 && uNum <= den;
+}
+
+#endif
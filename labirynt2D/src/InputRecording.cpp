@@ -0,0 +1,181 @@
+#include "InputRecording.hpp"
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+const char magic[4] = { 'L', '2', 'D', 'R' };
+const uint8_t version = 1;
+// tag bit of a gap record, key bytes never reach it
+const uint8_t skipTag = 0x80;
+
+void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+bool getVarint(const std::vector<uint8_t>& in, size_t& cursor, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && cursor < in.size(); shift += 7) {
+        uint8_t byte = in[cursor++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+// Fixed-size fields, little-endian whatever the host
+void putBits(std::vector<uint8_t>& out, uint64_t bits, int bytes) {
+    for (int i = 0; i < bytes; i++) out.push_back(static_cast<uint8_t>(bits >> (8 * i)));
+}
+
+uint64_t getBits(const std::vector<uint8_t>& in, size_t& cursor, int bytes) {
+    uint64_t bits = 0;
+    for (int i = 0; i < bytes && cursor < in.size(); i++) bits |= static_cast<uint64_t>(in[cursor++]) << (8 * i);
+    return bits;
+}
+
+void putFloat(std::vector<uint8_t>& out, float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    putBits(out, bits, 4);
+}
+
+float getFloat(const std::vector<uint8_t>& in, size_t& cursor) {
+    uint32_t bits = static_cast<uint32_t>(getBits(in, cursor, 4));
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+}
+
+InputRecording::InputRecording()
+    : seed(0), gridN(0), implicit(false), fieldResolution(0), tickRate(0), tickCount(0), finalPosition(0.0f),
+      finalAngle(0.0f), finishTick(notFinished), lastRecordTick(0), lastKeys(0) {
+    rewind();
+}
+
+void InputRecording::begin(unsigned int seed, int gridN, bool implicit, int fieldResolution, int tickRate) {
+    this->seed = seed;
+    this->gridN = gridN;
+    this->implicit = implicit;
+    this->fieldResolution = fieldResolution;
+    this->tickRate = tickRate;
+    tickCount = 0;
+    finishTick = notFinished;
+    stream.clear();
+    lastRecordTick = 0;
+    lastKeys = 0;
+    rewind();
+}
+
+void InputRecording::recordTick(uint64_t tick, unsigned int keys) {
+    if (keys == lastKeys) return;
+    writeRecord(tick, static_cast<uint8_t>(keys & ~skipTag));
+    lastKeys = keys;
+}
+
+void InputRecording::recordSkip(uint64_t firstTick, uint64_t count) {
+    if (count == 0) return;
+    writeRecord(firstTick, skipTag);
+    putVarint(stream, count);
+}
+
+void InputRecording::writeRecord(uint64_t tick, uint8_t tag) {
+    putVarint(stream, tick - lastRecordTick);
+    stream.push_back(tag);
+    lastRecordTick = tick;
+}
+
+void InputRecording::end(uint64_t tickCount, const glm::vec2& finalPosition, float finalAngle, int64_t finishTick) {
+    this->tickCount = tickCount;
+    this->finalPosition = finalPosition;
+    this->finalAngle = finalAngle;
+    this->finishTick = finishTick;
+}
+
+bool InputRecording::save(const std::string& path) const {
+    std::vector<uint8_t> out(magic, magic + sizeof(magic));
+    out.push_back(version);
+    putBits(out, seed, 4);
+    putBits(out, static_cast<uint32_t>(gridN), 4);
+    out.push_back(implicit ? 1 : 0);
+    putBits(out, static_cast<uint32_t>(fieldResolution), 4);
+    putBits(out, static_cast<uint32_t>(tickRate), 4);
+    putBits(out, tickCount, 8);
+    putFloat(out, finalPosition.x);
+    putFloat(out, finalPosition.y);
+    putFloat(out, finalAngle);
+    putBits(out, static_cast<uint64_t>(finishTick), 8);
+    putBits(out, stream.size(), 8);
+    out.insert(out.end(), stream.begin(), stream.end());
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(out.data()), static_cast<std::streamsize>(out.size()));
+    return static_cast<bool>(file);
+}
+
+bool InputRecording::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::vector<uint8_t> in((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    const size_t headerSize = sizeof(magic) + 1 + 4 + 4 + 1 + 4 + 4 + 8 + 4 * 3 + 8 + 8;
+    if (in.size() < headerSize || std::memcmp(in.data(), magic, sizeof(magic)) != 0 || in[4] != version) return false;
+
+    size_t cursor = sizeof(magic) + 1;
+    seed = static_cast<unsigned int>(getBits(in, cursor, 4));
+    gridN = static_cast<int>(getBits(in, cursor, 4));
+    implicit = in[cursor++] != 0;
+    fieldResolution = static_cast<int>(getBits(in, cursor, 4));
+    tickRate = static_cast<int>(getBits(in, cursor, 4));
+    tickCount = getBits(in, cursor, 8);
+    finalPosition.x = getFloat(in, cursor);
+    finalPosition.y = getFloat(in, cursor);
+    finalAngle = getFloat(in, cursor);
+    finishTick = static_cast<int64_t>(getBits(in, cursor, 8));
+    uint64_t streamSize = getBits(in, cursor, 8);
+    if (streamSize != in.size() - cursor) return false;
+    stream.assign(in.begin() + cursor, in.end());
+    rewind();
+    return true;
+}
+
+void InputRecording::rewind() {
+    cursor = 0;
+    readTick = 0;
+    playTick = 0;
+    playKeys = 0;
+    readRecord();
+}
+
+void InputRecording::readRecord() {
+    uint64_t delta;
+    pending = cursor < stream.size() && getVarint(stream, cursor, delta) && cursor < stream.size();
+    if (!pending) return;
+    pendingTick = readTick + delta;
+    readTick = pendingTick;
+    uint8_t tag = stream[cursor++];
+    pendingSkip = (tag & skipTag) != 0;
+    pendingValue = tag;
+    if (pendingSkip) pending = getVarint(stream, cursor, pendingValue);
+}
+
+bool InputRecording::next(uint64_t& tick, unsigned int& keys) {
+    while (playTick < tickCount) {
+        if (pending && pendingTick <= playTick) {
+            if (pendingSkip) playTick = pendingTick + pendingValue;
+            else playKeys = static_cast<unsigned int>(pendingValue);
+            readRecord();
+            continue;
+        }
+        tick = playTick++;
+        keys = playKeys;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,80 @@
+#ifndef INPUTRECORDING_HPP
+#define INPUTRECORDING_HPP
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Input of one play session, enough to replay it headless through the same movement and collision code.
+// The level is stored by its generator parameters (seed, GRID_N, mode), the keys as a delta stream: a record is
+// written only when the held keys change, as a varint count of ticks since the previous record and the new key
+// byte, and ticks the simulation skipped after a stall are stored as gaps. A few minutes of play take a few KB.
+// The final pose and finish tick of the recorded run let a replay check that it reproduced the session
+class InputRecording {
+public:
+    static const int64_t notFinished = -1;
+
+    InputRecording();
+
+    // Level and rate the session is played with, resets the recorded input
+    void begin(unsigned int seed, int gridN, bool implicit, int fieldResolution, int tickRate);
+
+    // Recording side, ticks in increasing order
+    void recordTick(uint64_t tick, unsigned int keys);
+    // Ticks firstTick .. firstTick + count - 1 were never executed
+    void recordSkip(uint64_t firstTick, uint64_t count);
+    void end(uint64_t tickCount, const glm::vec2& finalPosition, float finalAngle, int64_t finishTick);
+
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+    // Playback side: expands the stream into held keys per executed tick, walking it from the start
+    void rewind();
+    // Next executed tick and its keys, false once the stream is exhausted. Skipped ticks are jumped over,
+    // so tick can advance by more than one
+    bool next(uint64_t& tick, unsigned int& keys);
+
+    unsigned int getSeed() const { return seed; }
+    int getGridN() const { return gridN; }
+    bool isImplicit() const { return implicit; }
+    int getFieldResolution() const { return fieldResolution; }
+    int getTickRate() const { return tickRate; }
+    uint64_t getTickCount() const { return tickCount; }
+    glm::vec2 getFinalPosition() const { return finalPosition; }
+    float getFinalAngle() const { return finalAngle; }
+    int64_t getFinishTick() const { return finishTick; }
+    size_t getStreamBytes() const { return stream.size(); }
+
+private:
+    unsigned int seed;
+    int gridN;
+    bool implicit;
+    int fieldResolution;
+    int tickRate;
+    uint64_t tickCount;
+    glm::vec2 finalPosition;
+    float finalAngle;
+    int64_t finishTick;
+    std::vector<uint8_t> stream;
+
+    // recording state
+    uint64_t lastRecordTick; // tick the last record was written at
+    unsigned int lastKeys;
+
+    // playback state
+    size_t cursor;
+    uint64_t readTick;     // tick of the last record read
+    uint64_t playTick;     // next tick to hand out
+    unsigned int playKeys;
+    bool pending;          // a record has been read ahead and waits for its tick
+    bool pendingSkip;
+    uint64_t pendingTick;
+    uint64_t pendingValue; // keys, or the number of skipped ticks
+
+    void writeRecord(uint64_t tick, uint8_t tag);
+    void readRecord();
+};
+
+#endif
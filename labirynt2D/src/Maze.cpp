@@ -0,0 +1,376 @@
+#include "Maze.hpp"
+#include "ConvexCollision.hpp"
+#include "NeighborCache.hpp"
+#include "SegmentBatch.hpp"
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace {
+
+const float PI = 3.14159265358979323846f;
+const int maxSweepIterations = 32;
+
+// Implicit mode keeps the cell size of a GRID_N = 10 level whatever the maze size
+const float implicitStep = 0.2f;
+const float implicitLongDiag = 0.18f;
+const float implicitShortDiag = 0.05f;
+// the lattice origin follows the player once it is this many cells away
+const int recenterCells = 64;
+
+// Counter-based generator: the splitmix64 finalizer over (seed, i, j), uniform in [0, 1). Any cell can be drawn
+// in any order on any thread, and the integer mixing is the same on every platform and standard library
+float cellRandom(unsigned int seed, int i, int j) {
+    uint64_t x = static_cast<uint64_t>(seed) * 0x9E3779B97F4A7C15ull
+               + ((static_cast<uint64_t>(static_cast<uint32_t>(j)) << 32) | static_cast<uint32_t>(i));
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    x = x ^ (x >> 31);
+    return static_cast<float>(x >> 40) / static_cast<float>(1ull << 24);
+}
+
+void boundingBox(const glm::vec2* verts, int count, glm::vec2& boxMin, glm::vec2& boxMax) {
+    boxMin = boxMax = verts[0];
+    for (int i = 1; i < count; i++) {
+        boxMin = glm::min(boxMin, verts[i]);
+        boxMax = glm::max(boxMax, verts[i]);
+    }
+}
+
+}
+
+Maze::Maze()
+    : gridN(0), seed(0), implicit(false), left(-0.9f), bottom(-0.9f), step(0.0f), longDiag(0.0f), shortDiag(0.0f),
+      originI(0), originJ(0), finishCenter(0.9f, 0.9f), finishRotationSpeed(0.45f) {
+    finishLocal[0] = glm::vec2(0.08f, 0.05f);
+    finishLocal[1] = glm::vec2(-0.08f, 0.05f);
+    finishLocal[2] = glm::vec2(0.0f, -0.085f);
+}
+
+void Maze::generate(int gridN, unsigned int seed, unsigned int threadCount) {
+    setLayout(gridN, seed, false, 1.8f / (gridN - 1), 1.8f / gridN, 0.5f / gridN);
+
+    // every cell draws from its own counter (cellRandom), so bands of rows fill their slots independently
+    size_t count = gridN >= 2 ? static_cast<size_t>(gridN) * gridN - 2 : 0;
+    obstacles.resize(count);
+    instances.resize(count);
+
+    const int bandRows = 16;
+    int bandCount = (gridN + bandRows - 1) / bandRows;
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::min(threadCount, static_cast<unsigned int>(bandCount));
+
+    std::atomic<int> nextBand(0);
+    auto work = [&]() {
+        for (int band = nextBand++; band < bandCount; band = nextBand++) {
+            for (int j = band * bandRows; j < std::min(gridN, (band + 1) * bandRows); j++) {
+                for (int i = 0; i < gridN; i++) {
+                    if (grid.isEmptyCell(i, j)) continue;
+
+                    int index = grid.obstacleIndex(i, j);
+                    instances[index] = ObstacleInstance{ grid.cellCenter(i, j), obstacleAngle(i, j) };
+                    obstacles[index] = rhombusAt(instances[index].center.x, instances[index].center.y, instances[index].angle);
+                }
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned int t = 1; t < threadCount; t++) workers.emplace_back(work);
+    work();
+    for (std::thread& worker : workers) worker.join();
+}
+
+void Maze::generateImplicit(int gridN, unsigned int seed) {
+    setLayout(gridN, seed, true, implicitStep, implicitLongDiag, implicitShortDiag);
+    obstacles.shrink_to_fit();
+    instances.shrink_to_fit();
+}
+
+void Maze::setLayout(int gridN, unsigned int seed, bool implicit, float step, float longDiag, float shortDiag) {
+    this->gridN = gridN;
+    this->seed = seed;
+    this->implicit = implicit;
+    this->step = step;
+    this->longDiag = longDiag;
+    this->shortDiag = shortDiag;
+    originI = 0;
+    originJ = 0;
+
+    local[0] = glm::vec2(0.0f, longDiag / 2.0f);
+    local[1] = glm::vec2(shortDiag / 2.0f, 0.0f);
+    local[2] = glm::vec2(0.0f, -longDiag / 2.0f);
+    local[3] = glm::vec2(-shortDiag / 2.0f, 0.0f);
+
+    grid.build(gridN, left, bottom, step, longDiag / 2.0f);
+    field.clear();
+    occupancy.clear();
+    obstacles.clear();
+    instances.clear();
+}
+
+void Maze::bakeDistanceField(int resolution, unsigned int threadCount) {
+    if (implicit || resolution < 2) return;
+    glm::vec2 halfCell(step / 2.0f);
+    field.bake(*this, grid.cellCenter(0, 0) - halfCell, grid.cellCenter(gridN - 1, gridN - 1) + halfCell,
+               resolution, step, threadCount);
+}
+
+void Maze::bakeOccupancy(int resolution, unsigned int threadCount) {
+    if (implicit || resolution < 1) return;
+    glm::vec2 halfCell(step / 2.0f);
+    occupancy.build(*this, grid.cellCenter(0, 0) - halfCell, grid.cellCenter(gridN - 1, gridN - 1) + halfCell,
+                    resolution, threadCount);
+}
+
+float Maze::obstacleAngle(int i, int j) const {
+    return cellRandom(seed, i, j) * 2.0f * PI;
+}
+
+Rhombus Maze::obstacleAt(int i, int j) const {
+    if (implicit) {
+        glm::vec2 center = grid.cellCenter(i, j);
+        return rhombusAt(center.x, center.y, obstacleAngle(i, j));
+    }
+    return obstacles[grid.obstacleIndex(i, j)];
+}
+
+void Maze::collectInstances(const glm::vec2& boxMin, const glm::vec2& boxMax, std::vector<ObstacleInstance>& result) const {
+    result.clear();
+    grid.forEachObstacle(grid.cellsOverlapping(boxMin, boxMax), [&](int i, int j) {
+        result.push_back(ObstacleInstance{ grid.cellCenter(i, j), obstacleAngle(i, j) });
+        return false;
+    });
+}
+
+void Maze::collectRecords(const glm::vec2& boxMin, const glm::vec2& boxMax, std::vector<ObstacleRecord>& result) const {
+    result.clear();
+    glm::vec2 playerReach(longDiag / 2.0f);
+    grid.forEachObstacle(grid.cellsOverlapping(boxMin - playerReach, boxMax + playerReach), [&](int i, int j) {
+        result.push_back(ObstacleRecord{ obstacleAt(i, j), grid.cellCenter(i, j) });
+        return false;
+    });
+}
+
+glm::vec2 Maze::recenter(float x, float y) {
+    if (!implicit) return glm::vec2(0.0f);
+
+    int shiftI = static_cast<int>(std::floor((x - left) / step));
+    int shiftJ = static_cast<int>(std::floor((y - bottom) / step));
+    if (std::abs(shiftI) < recenterCells && std::abs(shiftJ) < recenterCells) return glm::vec2(0.0f);
+
+    originI += shiftI;
+    originJ += shiftJ;
+    grid.setOrigin(originI, originJ);
+    return glm::vec2(shiftI * step, shiftJ * step);
+}
+
+glm::vec2 Maze::getFinishCenter() const {
+    return implicit ? grid.cellCenter(gridN - 1, gridN - 1) : finishCenter;
+}
+
+Rhombus Maze::rhombusAt(float x, float y, float angle) const {
+    Rhombus verts;
+    float cos = std::cos(angle);
+    float sin = std::sin(angle);
+    for (int i = 0; i < 4; i++) {
+        verts[i] = glm::vec2(local[i].x * cos - local[i].y * sin + x,
+                             local[i].x * sin + local[i].y * cos + y);
+    }
+    return verts;
+}
+
+Triangle Maze::finishTriangleAt(float time) const {
+    Triangle verts;
+    float finishAngle = finishAngleAt(time);
+    float cos = std::cos(finishAngle);
+    float sin = std::sin(finishAngle);
+    glm::vec2 center = getFinishCenter();
+    for (int i = 0; i < 3; i++) {
+        verts[i] = glm::vec2(finishLocal[i].x * cos - finishLocal[i].y * sin + center.x,
+                             finishLocal[i].x * sin + finishLocal[i].y * cos + center.y);
+    }
+    return verts;
+}
+
+bool Maze::overlapsCells(const Rhombus& poly, const CellRange& range, glm::vec2* pushOut) const {
+    if (!pushOut) {
+        return grid.forEachObstacle(range, [&](int i, int j) {
+            Rhombus obstacle = obstacleAt(i, j);
+            return polygonsCollide(poly.data(), 4, obstacle.data(), 4);
+        });
+    }
+
+    bool hit = false;
+    *pushOut = glm::vec2(0.0f);
+    grid.forEachObstacle(range, [&](int i, int j) {
+        Contact contact;
+        Rhombus obstacle = obstacleAt(i, j);
+        if (polygonsCollide(poly.data(), 4, obstacle.data(), 4, &contact)) {
+            *pushOut += contact.normal * contact.depth;
+            hit = true;
+        }
+        return false;
+    });
+    return hit;
+}
+
+bool Maze::playerCollides(float x, float y, float angle, glm::vec2* pushOut) const {
+    if (!pushOut && occupancy.isBuilt()) {
+        Rhombus poly = rhombusAt(x, y, angle);
+        return occupancy.overlaps(poly.data(), 4);
+    }
+    Rhombus poly = rhombusAt(x, y, angle);
+    glm::vec2 boxMin, boxMax;
+    boundingBox(poly.data(), 4, boxMin, boxMax);
+    return overlapsCells(poly, grid.cellsOverlapping(boxMin, boxMax), pushOut);
+}
+
+bool Maze::overlapsRecords(const Rhombus& poly, const glm::vec2& center, const std::vector<ObstacleRecord>& records,
+                           glm::vec2* pushOut) const {
+    bool hit = false;
+    if (pushOut) *pushOut = glm::vec2(0.0f);
+    for (const ObstacleRecord& record : records) {
+        // two rhombi whose centers are a long diagonal apart cannot touch
+        glm::vec2 offset = record.center - center;
+        if (glm::dot(offset, offset) > longDiag * longDiag) continue;
+
+        Contact contact;
+        if (!polygonsCollide(poly.data(), 4, record.poly.data(), 4, pushOut ? &contact : nullptr)) continue;
+        if (!pushOut) return true;
+        *pushOut += contact.normal * contact.depth;
+        hit = true;
+    }
+    return hit;
+}
+
+float Maze::maxPushFor(float fromX, float fromY, float fromAngle, float toX, float toY, float toAngle) const {
+    // no vertex moves further than this, so no valid push-out is longer either
+    return glm::length(glm::vec2(toX - fromX, toY - fromY)) + std::abs(toAngle - fromAngle) * longDiag / 2.0f;
+}
+
+bool Maze::resolveMove(float fromX, float fromY, float fromAngle, float& toX, float& toY, float toAngle) const {
+    // one set of obstacles around the target grown by the largest possible push serves both the target
+    // and the resolved pose
+    glm::vec2 maxPush(maxPushFor(fromX, fromY, fromAngle, toX, toY, toAngle));
+    thread_local std::vector<ObstacleRecord> records;
+    collectRecords(glm::vec2(toX, toY) - maxPush, glm::vec2(toX, toY) + maxPush, records);
+    return resolveAgainst(records, nullptr, fromX, fromY, fromAngle, toX, toY, toAngle);
+}
+
+bool Maze::resolveMove(float fromX, float fromY, float fromAngle, float& toX, float& toY, float toAngle,
+                       NeighborCache& cache) const {
+    glm::vec2 maxPush(maxPushFor(fromX, fromY, fromAngle, toX, toY, toAngle));
+    cache.prepare(*this, glm::vec2(toX, toY) - maxPush, glm::vec2(toX, toY) + maxPush);
+    return resolveAgainst(cache.getRecords(), &cache.getEdges(), fromX, fromY, fromAngle, toX, toY, toAngle);
+}
+
+bool Maze::resolveAgainst(const std::vector<ObstacleRecord>& records, const EdgeBatch* edges, float fromX, float fromY,
+                          float fromAngle, float& toX, float& toY, float toAngle) const {
+    glm::vec2 target(toX, toY);
+    glm::vec2 pushOut;
+    if (!overlapsRecords(rhombusAt(toX, toY, toAngle), target, records, &pushOut)) return true;
+
+    const float slop = 1e-5f; // keeps the resolved pose from resting exactly on the edge
+    float pushLength = glm::length(pushOut);
+    float maxPush = maxPushFor(fromX, fromY, fromAngle, toX, toY, toAngle);
+    if (pushLength == 0.0f || pushLength > maxPush + slop) return false; // deeper than the move itself
+
+    glm::vec2 resolved = target + pushOut * ((pushLength + slop) / pushLength);
+    Rhombus poly = rhombusAt(resolved.x, resolved.y, toAngle);
+    // only a yes/no is needed here: the player is congruent to the obstacles, so crossing outlines mean overlap
+    bool blocked = edges ? polygonCrossesEdges(poly.data(), 4, *edges)
+                         : overlapsRecords(poly, resolved, records, nullptr);
+    if (blocked) return false;
+
+    toX = resolved.x;
+    toY = resolved.y;
+    return true;
+}
+
+float Maze::sweepTimeOfImpact(float fromX, float fromY, float fromAngle, float toX, float toY, float toAngle) const {
+    thread_local std::vector<ObstacleRecord> candidates;
+    candidates.clear();
+    grid.forEachObstacleAlong(glm::vec2(fromX, fromY), glm::vec2(toX, toY), longDiag / 2.0f, [&](int i, int j) {
+        candidates.push_back(ObstacleRecord{ obstacleAt(i, j), grid.cellCenter(i, j) });
+        return false;
+    });
+    return sweepAgainst(candidates, fromX, fromY, fromAngle, toX, toY, toAngle);
+}
+
+float Maze::sweepTimeOfImpact(float fromX, float fromY, float fromAngle, float toX, float toY, float toAngle,
+                              NeighborCache& cache) const {
+    glm::vec2 from(fromX, fromY), to(toX, toY);
+    cache.prepare(*this, glm::min(from, to), glm::max(from, to));
+    return sweepAgainst(cache.getRecords(), fromX, fromY, fromAngle, toX, toY, toAngle);
+}
+
+void Maze::slideMove(float& x, float& y, float& angle, float toX, float toY, float toAngle, NeighborCache& cache) const {
+    // sweep first so a long step stops at the first contact instead of tunnelling through a thin rhombus
+    float t = sweepTimeOfImpact(x, y, angle, toX, toY, toAngle, cache);
+    if (t >= 1.0f) {
+        x = toX;
+        y = toY;
+        angle = toAngle;
+        return;
+    }
+    x += (toX - x) * t;
+    y += (toY - y) * t;
+    angle += (toAngle - angle) * t;
+
+    // the rest of the motion slides along the obstacle that was hit
+    if (resolveMove(x, y, angle, toX, toY, toAngle, cache)) {
+        x = toX;
+        y = toY;
+        angle = toAngle;
+    }
+}
+
+float Maze::sweepAgainst(const std::vector<ObstacleRecord>& candidates, float fromX, float fromY, float fromAngle,
+                         float toX, float toY, float toAngle) const {
+    if (candidates.empty()) return 1.0f;
+    const float reach = longDiag / 2.0f;
+
+    // no point of the player moves faster than this over the whole motion
+    float bound = maxPushFor(fromX, fromY, fromAngle, toX, toY, toAngle);
+    if (bound == 0.0f) {
+        glm::vec2 center(fromX, fromY);
+        return overlapsRecords(rhombusAt(fromX, fromY, fromAngle), center, candidates, nullptr) ? 0.0f : 1.0f;
+    }
+
+    // conservative advancement: the player cannot close a gap of d in less than d / bound
+    const float gap = 1e-4f * longDiag; // counts as contact, the player stays about half of it away
+    float t = 0.0f;
+    for (int iteration = 0; iteration < maxSweepIterations; iteration++) {
+        glm::vec2 center(fromX + (toX - fromX) * t, fromY + (toY - fromY) * t);
+        Rhombus poly = rhombusAt(center.x, center.y, fromAngle + (toAngle - fromAngle) * t);
+
+        // obstacles at least this far away cannot stop the rest of the motion
+        float distance = bound * (1.0f - t) + gap;
+        for (const ObstacleRecord& candidate : candidates) {
+            // bounding circles first, the polygon test only runs for obstacles that could come closer
+            glm::vec2 offset = candidate.center - center;
+            float circleReach = distance + 2.0f * reach;
+            if (glm::dot(offset, offset) >= circleReach * circleReach) continue;
+
+            distance = std::fmin(distance, polygonSeparation(poly.data(), 4, candidate.poly.data(), 4, distance));
+            if (distance == 0.0f) break;
+        }
+
+        if (distance < gap) return t;
+        t += (distance - 0.5f * gap) / bound;
+        if (t >= 1.0f) return 1.0f;
+    }
+    return t;
+}
+
+bool Maze::playerReachesFinish(float x, float y, float angle, float time) const {
+    Rhombus poly = rhombusAt(x, y, angle);
+    Triangle finish = finishTriangleAt(time);
+    return polygonsCollide(poly.data(), 4, finish.data(), 3);
+}
+
+size_t Maze::memoryUsage() const {
+    return obstacles.capacity() * sizeof(Rhombus) + instances.capacity() * sizeof(ObstacleInstance);
+}
@@ -0,0 +1,152 @@
+#ifndef MAZE_HPP
+#define MAZE_HPP
+
+#include <glm/glm.hpp>
+#include <array>
+#include <vector>
+#include <cstddef>
+#include "ObstacleGrid.hpp"
+#include "DistanceField.hpp"
+#include "OccupancyRaster.hpp"
+
+using Rhombus = std::array<glm::vec2, 4>;
+using Triangle = std::array<glm::vec2, 3>;
+
+// Per-instance obstacle data for the renderer: 12 bytes, the shader rotates the shared rhombus itself
+struct ObstacleInstance {
+    glm::vec2 center;
+    float angle;
+};
+
+// Obstacle fetched for a run of queries: its vertices and center side by side
+struct ObstacleRecord {
+    Rhombus poly;
+    glm::vec2 center;
+};
+
+class NeighborCache;
+struct EdgeBatch;
+
+// Obstacle layout of the level and every collision query against it. Has no GL dependency,
+// so the simulation can be profiled and scaled headless (bench/maze2d_bench.cpp).
+class Maze {
+public:
+    Maze();
+
+    // GRID_N x GRID_N randomly rotated rhombi in [-0.9, 0.9], the start and finish cells stay empty.
+    // Bands of rows are generated on threadCount threads (0 - one per hardware thread); the layout depends
+    // only on the seed, never on the thread count or the platform's rand()
+    void generate(int gridN, unsigned int seed, unsigned int threadCount = 0);
+
+    // Same lattice with no per-obstacle storage: the rotation of cell (i, j) is the same hash of (seed, i, j)
+    // and obstacles are built on demand. Cells keep the size of a 10 x 10 level, so the maze reaches far beyond
+    // the screen (up to 1,000,000 x 1,000,000 in constant memory) and is viewed through a following camera
+    void generateImplicit(int gridN, unsigned int seed);
+
+    // Bakes the signed distance field of a stored layout over its whole square (resolution x resolution
+    // texels, distances truncated at one cell step) for the renderer's proximity glow
+    void bakeDistanceField(int resolution, unsigned int threadCount = 0);
+
+    // Optional collision backend of a stored layout: the obstacles rasterized once into a resolution x resolution
+    // bit grid over the same square as the distance field. Yes/no pose queries (playerCollides without pushOut)
+    // are then answered from the bits, within a texel of the exact test
+    void bakeOccupancy(int resolution, unsigned int threadCount = 0);
+
+    // Rotation of the obstacle in cell (i, j), drawn from the counter-based generator keyed by (seed, i, j)
+    float obstacleAngle(int i, int j) const;
+    Rhombus obstacleAt(int i, int j) const;
+
+    // Render instances of the obstacles whose cells overlap the box, the visible part of an implicit maze
+    void collectInstances(const glm::vec2& boxMin, const glm::vec2& boxMax, std::vector<ObstacleInstance>& result) const;
+    // Every obstacle that a player centered anywhere in [boxMin, boxMax] can touch
+    void collectRecords(const glm::vec2& boxMin, const glm::vec2& boxMax, std::vector<ObstacleRecord>& result) const;
+
+    // Implicit mode only: once (x, y) drifts far from the lattice origin, the origin moves by whole cells.
+    // Returns the shift that every local position (the player's) has to be moved back by, keeping
+    // float coordinates small and precise anywhere in the maze
+    glm::vec2 recenter(float x, float y);
+
+    // Rhombus of the shared player/obstacle shape placed at (x, y) and rotated by angle
+    Rhombus rhombusAt(float x, float y, float angle) const;
+    // Rotating finish marker at the given time (seconds)
+    Triangle finishTriangleAt(float time) const;
+    float finishAngleAt(float time) const { return time * finishRotationSpeed; }
+
+    // Separating axis test of the pose against the obstacles around it. On overlap pushOut (if given)
+    // holds the summed minimum translation that moves the pose out of every obstacle it touches
+    bool playerCollides(float x, float y, float angle, glm::vec2* pushOut = nullptr) const;
+
+    // Validates the move from (fromX, fromY, fromAngle) to (toX, toY, toAngle). A blocked pose is pushed out
+    // along the contact normals so the player slides along the obstacle; toX/toY then hold the resolved
+    // position. Returns false when the move has to be rejected
+    bool resolveMove(float fromX, float fromY, float fromAngle, float& toX, float& toY, float toAngle) const;
+    bool resolveMove(float fromX, float fromY, float fromAngle, float& toX, float& toY, float toAngle,
+                     NeighborCache& cache) const;
+
+    // Continuous test of the motion from one pose to the other (position and angle interpolated linearly).
+    // Returns the conservative time of impact in [0, 1]: the player can move that fraction of the way and
+    // still be clear of every obstacle, 1 means the whole motion is free. Only cells along the path are visited
+    float sweepTimeOfImpact(float fromX, float fromY, float fromAngle, float toX, float toY, float toAngle) const;
+    // Same queries answered from the player's neighbor list, which is rebuilt only when the motion leaves it
+    float sweepTimeOfImpact(float fromX, float fromY, float fromAngle, float toX, float toY, float toAngle,
+                            NeighborCache& cache) const;
+
+    // The move of Player and the agents: sweeps from (x, y, angle) towards the target pose, stops at the first
+    // contact and slides the rest of the motion along the obstacle hit. x, y, angle then hold the pose reached
+    void slideMove(float& x, float& y, float& angle, float toX, float toY, float toAngle, NeighborCache& cache) const;
+
+    bool playerReachesFinish(float x, float y, float angle, float time) const;
+
+    // Stored obstacles, empty in implicit mode
+    const std::vector<Rhombus>& getObstacles() const { return obstacles; }
+    const std::vector<ObstacleInstance>& getInstances() const { return instances; }
+    const ObstacleGrid& getGrid() const { return grid; }
+    const DistanceField& getDistanceField() const { return field; }
+    const OccupancyRaster& getOccupancy() const { return occupancy; }
+    const glm::vec2* getLocal() const { return local; }
+    glm::vec2 getFinishCenter() const;
+    int getGridN() const { return gridN; }
+    bool isImplicit() const { return implicit; }
+    float getLongDiag() const { return longDiag; }
+    float getShortDiag() const { return shortDiag; }
+    float getStep() const { return step; }
+
+    // Bytes held by the obstacle storage (collision vertices and render instances)
+    size_t memoryUsage() const;
+
+private:
+    int gridN;
+    unsigned int seed;
+    bool implicit;
+    float left;
+    float bottom;
+    float step;
+    float longDiag;
+    float shortDiag;
+    glm::vec2 local[4]; // top, right, bottom, left vertex of the rhombus around its center
+    int originI;        // lattice cell currently placed at (left, bottom)
+    int originJ;
+
+    std::vector<Rhombus> obstacles;
+    std::vector<ObstacleInstance> instances; // same order as obstacles
+    ObstacleGrid grid;
+    DistanceField field;
+    OccupancyRaster occupancy;
+
+    glm::vec2 finishLocal[3];
+    glm::vec2 finishCenter;
+    float finishRotationSpeed;
+
+    void setLayout(int gridN, unsigned int seed, bool implicit, float step, float longDiag, float shortDiag);
+    bool overlapsCells(const Rhombus& poly, const CellRange& range, glm::vec2* pushOut) const;
+    bool overlapsRecords(const Rhombus& poly, const glm::vec2& center, const std::vector<ObstacleRecord>& records,
+                         glm::vec2* pushOut) const;
+    float maxPushFor(float fromX, float fromY, float fromAngle, float toX, float toY, float toAngle) const;
+    // edges (if given) outline the same obstacles and answer the final overlap check with the batched kernel
+    bool resolveAgainst(const std::vector<ObstacleRecord>& records, const EdgeBatch* edges, float fromX, float fromY,
+                        float fromAngle, float& toX, float& toY, float toAngle) const;
+    float sweepAgainst(const std::vector<ObstacleRecord>& records, float fromX, float fromY, float fromAngle,
+                       float toX, float toY, float toAngle) const;
+};
+
+#endif
@@ -0,0 +1,34 @@
+#include "NeighborCache.hpp"
+
+NeighborCache::NeighborCache(float skin)
+    : skin(skin), valid(false), coveredMin(0.0f), coveredMax(0.0f), hits(0), rebuilds(0) {
+}
+
+void NeighborCache::prepare(const Maze& maze, const glm::vec2& boxMin, const glm::vec2& boxMax) {
+    if (valid && boxMin.x >= coveredMin.x && boxMin.y >= coveredMin.y &&
+        boxMax.x <= coveredMax.x && boxMax.y <= coveredMax.y) {
+        hits++;
+        return;
+    }
+
+    glm::vec2 margin(skin * maze.getLongDiag());
+    coveredMin = boxMin - margin;
+    coveredMax = boxMax + margin;
+    maze.collectRecords(coveredMin, coveredMax, records);
+    edges.clear();
+    for (const ObstacleRecord& record : records) {
+        edges.addPolygon(record.poly.data(), 4);
+    }
+    valid = true;
+    rebuilds++;
+}
+
+void NeighborCache::setSkin(float skin) {
+    this->skin = skin;
+    valid = false;
+}
+
+void NeighborCache::resetCounters() {
+    hits = 0;
+    rebuilds = 0;
+}
@@ -0,0 +1,48 @@
+#ifndef NEIGHBORCACHE_HPP
+#define NEIGHBORCACHE_HPP
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstddef>
+#include "Maze.hpp"
+#include "SegmentBatch.hpp"
+
+// Verlet list of the obstacles around one player. The player moves a fraction of a rhombus per frame, so the
+// obstacles it can touch are fetched once into a contiguous array and reused until it leaves the skin around
+// the pose they were fetched for. Maze's cached query overloads read the records instead of walking the lattice.
+class NeighborCache {
+public:
+    // skin - how far (in long diagonals of the rhombus) the player may drift before the list is rebuilt
+    explicit NeighborCache(float skin = 0.5f);
+
+    // Makes sure every obstacle that can touch a player centered anywhere in [boxMin, boxMax] is cached,
+    // rebuilding the list around the box when it reaches past the cached area
+    void prepare(const Maze& maze, const glm::vec2& boxMin, const glm::vec2& boxMax);
+
+    // The maze was regenerated or its lattice origin moved, the records no longer match it
+    void invalidate() { valid = false; }
+
+    const std::vector<ObstacleRecord>& getRecords() const { return records; }
+    // Outlines of the same obstacles as SoA edges for the batched crossing kernels
+    const EdgeBatch& getEdges() const { return edges; }
+
+    float getSkin() const { return skin; }
+    void setSkin(float skin);
+
+    // Queries served from the list and rebuilds, to tune the skin width
+    size_t getHits() const { return hits; }
+    size_t getRebuilds() const { return rebuilds; }
+    void resetCounters();
+
+private:
+    float skin;
+    bool valid;
+    glm::vec2 coveredMin; // player centers the records are complete for
+    glm::vec2 coveredMax;
+    std::vector<ObstacleRecord> records;
+    EdgeBatch edges;
+    size_t hits;
+    size_t rebuilds;
+};
+
+#endif
@@ -0,0 +1,38 @@
+#include "ObstacleGrid.hpp"
+
+ObstacleGrid::ObstacleGrid()
+    : gridN(0), left(0.0f), bottom(0.0f), step(1.0f), reach(0.0f), originI(0), originJ(0) {
+}
+
+void ObstacleGrid::build(int gridN, float left, float bottom, float step, float obstacleReach) {
+    this->gridN = gridN;
+    this->left = left;
+    this->bottom = bottom;
+    this->step = step;
+    this->reach = obstacleReach;
+    originI = 0;
+    originJ = 0;
+}
+
+void ObstacleGrid::setOrigin(int originI, int originJ) {
+    this->originI = originI;
+    this->originJ = originJ;
+}
+
+int ObstacleGrid::obstacleIndex(int i, int j) const {
+    if (isEmptyCell(i, j)) return -1;
+    // only the (0, 0) cell is skipped before any other cell, the finish cell is the very last one
+    return j * gridN + i - 1;
+}
+
+CellRange ObstacleGrid::cellsOverlapping(const glm::vec2& boxMin, const glm::vec2& boxMax) const {
+    if (gridN < 2) return CellRange{ 0, -1, 0, -1 };
+
+    // floor/ceil keep the range conservative, one extra row or column is cheaper than a missed hit
+    CellRange range;
+    range.iMin = std::max(0, cellIndex(boxMin.x - reach, left, originI, false));
+    range.iMax = std::min(gridN - 1, cellIndex(boxMax.x + reach, left, originI, true));
+    range.jMin = std::max(0, cellIndex(boxMin.y - reach, bottom, originJ, false));
+    range.jMax = std::min(gridN - 1, cellIndex(boxMax.y + reach, bottom, originJ, true));
+    return range;
+}
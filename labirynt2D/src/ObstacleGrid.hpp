@@ -0,0 +1,124 @@
+#ifndef OBSTACLEGRID_HPP
+#define OBSTACLEGRID_HPP
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+// Inclusive range of lattice cells, empty when iMin > iMax or jMin > jMax
+struct CellRange {
+    int iMin, iMax;
+    int jMin, jMax;
+};
+
+// Broadphase over the rhombus lattice. Every obstacle sits in its own cell (center = left + i * step),
+// so the cells overlapped by a box are found with plain arithmetic and nothing is stored per cell.
+// The lattice can be shifted by whole cells (setOrigin) to keep local coordinates small in huge mazes.
+class ObstacleGrid {
+public:
+    ObstacleGrid();
+
+    // obstacleReach - largest distance from a rhombus center to any of its vertices
+    void build(int gridN, float left, float bottom, float step, float obstacleReach);
+
+    // Cell (originI, originJ) takes the place of cell (0, 0): its center becomes (left, bottom)
+    void setOrigin(int originI, int originJ);
+
+    // The start and finish corners hold no obstacle
+    bool isEmptyCell(int i, int j) const {
+        return (i == 0 && j == 0) || (i == gridN - 1 && j == gridN - 1);
+    }
+
+    // Index into a stored obstacles vector (generated row by row, j outer), -1 for the empty cells
+    int obstacleIndex(int i, int j) const;
+
+    glm::vec2 cellCenter(int i, int j) const {
+        return glm::vec2(left + (i - originI) * step, bottom + (j - originJ) * step);
+    }
+
+    // Cells whose obstacle can touch the box [boxMin, boxMax]
+    CellRange cellsOverlapping(const glm::vec2& boxMin, const glm::vec2& boxMax) const;
+
+    // Calls visit(i, j) for every obstacle in range, stops early and returns true once visit returns true
+    template <typename Visitor>
+    bool forEachObstacle(const CellRange& range, Visitor&& visit) const {
+        for (int j = range.jMin; j <= range.jMax; j++) {
+            for (int i = range.iMin; i <= range.iMax; i++) {
+                if (!isEmptyCell(i, j) && visit(i, j)) return true;
+            }
+        }
+        return false;
+    }
+
+    // Calls visit(i, j) for every obstacle that a shape of the given reach can touch while its center moves
+    // from -> to. Only the rows the segment crosses are walked, and within a row only the cells near the
+    // segment, so the cost follows the length of the motion rather than its bounding box
+    template <typename Visitor>
+    bool forEachObstacleAlong(const glm::vec2& from, const glm::vec2& to, float shapeReach, Visitor&& visit) const {
+        if (gridN < 2) return false;
+
+        float r = shapeReach + reach;
+        glm::vec2 d = to - from;
+        float lengthSq = glm::dot(d, d);
+
+        int jMin = std::max(0, cellIndex(std::min(from.y, to.y) - r, bottom, originJ, false));
+        int jMax = std::min(gridN - 1, cellIndex(std::max(from.y, to.y) + r, bottom, originJ, true));
+        for (int j = jMin; j <= jMax; j++) {
+            float rowY = cellCenter(0, j).y;
+
+            // part of the segment within r of this row
+            float tA = 0.0f, tB = 1.0f;
+            if (d.y != 0.0f) {
+                tA = (rowY - r - from.y) / d.y;
+                tB = (rowY + r - from.y) / d.y;
+                if (tA > tB) std::swap(tA, tB);
+                tA = std::max(tA, 0.0f);
+                tB = std::min(tB, 1.0f);
+                if (tA > tB) continue;
+            } else if (std::abs(from.y - rowY) > r) {
+                continue;
+            }
+            float xA = std::min(from.x + d.x * tA, from.x + d.x * tB);
+            float xB = std::max(from.x + d.x * tA, from.x + d.x * tB);
+
+            int iMin = std::max(0, cellIndex(xA - r, left, originI, false));
+            int iMax = std::min(gridN - 1, cellIndex(xB + r, left, originI, true));
+            for (int i = iMin; i <= iMax; i++) {
+                if (isEmptyCell(i, j)) continue;
+
+                // exact distance from the cell center to the segment
+                glm::vec2 center = cellCenter(i, j);
+                float t = (lengthSq > 0.0f) ? glm::clamp(glm::dot(center - from, d) / lengthSq, 0.0f, 1.0f) : 0.0f;
+                glm::vec2 offset = center - (from + d * t);
+                if (glm::dot(offset, offset) > r * r) continue;
+
+                if (visit(i, j)) return true;
+            }
+        }
+        return false;
+    }
+
+    int getGridN() const { return gridN; }
+    float getStep() const { return step; }
+
+private:
+    int gridN;
+    float left;
+    float bottom;
+    float step;
+    float reach;
+    int originI;
+    int originJ;
+
+    // Lattice index of a local coordinate, rounded down or up so ranges stay conservative
+    int cellIndex(float coord, float start, int origin, bool roundUp) const {
+        float cell = (coord - start) / step;
+        // clamp to just outside the maze before the int conversion, far-away coordinates would overflow it
+        cell = glm::clamp(roundUp ? std::ceil(cell) : std::floor(cell),
+                          static_cast<float>(-1 - origin), static_cast<float>(gridN - origin));
+        return static_cast<int>(cell) + origin;
+    }
+};
+
+#endif
@@ -0,0 +1,288 @@
+#include "OccupancyRaster.hpp"
+#include "Maze.hpp"
+#include <algorithm>
+#include <atomic>
+#include <bitset>
+#include <cmath>
+#include <thread>
+
+namespace {
+
+const int bandTileRows = 8;
+// rows of a shape kept on the stack during a query, taller ones fall back to thread-local buffers
+const int stackRows = 256;
+
+// Bits lo..hi (inclusive) of one 8-bit tile row
+uint64_t rowMask(int lo, int hi) {
+    return (0xFFull >> (7 - hi)) & (0xFFull << lo);
+}
+
+// floor / ceil to int without the libm call baseline x86-64 makes for std::floor (a query converts ~80 values)
+int floorToInt(float v) {
+    v = std::max(-1e9f, std::min(v, 1e9f));
+    int i = static_cast<int>(v);
+    return i - (v < static_cast<float>(i));
+}
+
+int ceilToInt(float v) {
+    return -floorToInt(-v);
+}
+
+size_t popcount(uint64_t word) {
+    return std::bitset<64>(word).count();
+}
+
+// ORs neighbouring bit pairs and packs the 32 results into the low half
+uint64_t compactPairs(uint64_t x) {
+    x = (x | (x >> 1)) & 0x5555555555555555ull;
+    x = (x | (x >> 1)) & 0x3333333333333333ull;
+    x = (x | (x >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+    x = (x | (x >> 4)) & 0x00FF00FF00FF00FFull;
+    x = (x | (x >> 8)) & 0x0000FFFF0000FFFFull;
+    x = (x | (x >> 16)) & 0x00000000FFFFFFFFull;
+    return x;
+}
+
+}
+
+OccupancyRaster::OccupancyRaster()
+    : resolution(0), tilesPerSide(0), boxMin(0.0f), texel(0.0f), invTexel(0.0f) {
+}
+
+void OccupancyRaster::build(const Maze& maze, const glm::vec2& boxMin, const glm::vec2& boxMax, int resolution,
+                            unsigned int threadCount) {
+    clear();
+    if (resolution < 1) return;
+    this->resolution = resolution;
+    this->boxMin = boxMin;
+    texel = std::max(boxMax.x - boxMin.x, boxMax.y - boxMin.y) / resolution;
+    invTexel = 1.0f / texel;
+    tilesPerSide = (resolution + tileSize - 1) / tileSize;
+    tiles.assign(static_cast<size_t>(tilesPerSide) * tilesPerSide, 0);
+
+    // every band writes only its own tiles, obstacles reaching into two bands are rasterized by both
+    int bandCount = (tilesPerSide + bandTileRows - 1) / bandTileRows;
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+    threadCount = std::min(threadCount, static_cast<unsigned int>(bandCount));
+    std::atomic<int> nextBand(0);
+    auto work = [&]() {
+        for (int band = nextBand++; band < bandCount; band = nextBand++) {
+            rasterizeBand(maze, band * bandTileRows, std::min(tilesPerSide, (band + 1) * bandTileRows));
+        }
+    };
+    std::vector<std::thread> workers;
+    for (unsigned int t = 1; t < threadCount; t++) workers.emplace_back(work);
+    work();
+    for (std::thread& worker : workers) worker.join();
+
+    for (int level = 0; level < maxLevels; level++) {
+        int size = (tilesPerSide + (1 << level) - 1) >> level;
+        levelSize.push_back(size);
+        wordsPerRow.push_back((size + 63) / 64);
+        levels.emplace_back(static_cast<size_t>(size) * wordsPerRow.back(), 0);
+        buildLevel(level);
+        if (size == 1) break;
+    }
+}
+
+void OccupancyRaster::clear() {
+    resolution = 0;
+    tilesPerSide = 0;
+    tiles.clear();
+    tiles.shrink_to_fit();
+    levels.clear();
+    levelSize.clear();
+    wordsPerRow.clear();
+}
+
+void OccupancyRaster::rasterizeBand(const Maze& maze, int tileRowBegin, int tileRowEnd) {
+    int rowBegin = tileRowBegin * tileSize, rowEnd = std::min(resolution, tileRowEnd * tileSize);
+    glm::vec2 bandMin = boxMin + glm::vec2(0.0f, rowBegin * texel);
+    glm::vec2 bandMax = boxMin + glm::vec2(resolution * texel, rowEnd * texel);
+    const ObstacleGrid& grid = maze.getGrid();
+    std::vector<int> first, last;
+
+    grid.forEachObstacle(grid.cellsOverlapping(bandMin, bandMax), [&](int i, int j) {
+        Rhombus poly = maze.obstacleAt(i, j);
+        int x0, y0, x1, y1;
+        if (!texelBounds(poly.data(), 4, x0, y0, x1, y1)) return false;
+        y0 = std::max(y0, rowBegin);
+        y1 = std::min(y1, rowEnd - 1);
+        if (y0 > y1) return false;
+        first.resize(y1 - y0 + 1);
+        last.resize(y1 - y0 + 1);
+        rowSpans(poly.data(), 4, y0, y1, first.data(), last.data());
+        for (int y = y0; y <= y1; y++) {
+            int c0 = first[y - y0], c1 = last[y - y0];
+            uint64_t* row = &tiles[static_cast<size_t>(y / tileSize) * tilesPerSide];
+            for (int tx = c0 / tileSize; tx <= c1 / tileSize && c0 <= c1; tx++) {
+                int lo = std::max(c0, tx * tileSize) - tx * tileSize, hi = std::min(c1, tx * tileSize + 7) - tx * tileSize;
+                row[tx] |= rowMask(lo, hi) << (tileSize * (y % tileSize));
+            }
+        }
+        return false;
+    });
+}
+
+void OccupancyRaster::buildLevel(int level) {
+    std::vector<uint64_t>& words = levels[level];
+    int size = levelSize[level];
+    for (int y = 0; y < size; y++) {
+        uint64_t* row = &words[static_cast<size_t>(y) * wordsPerRow[level]];
+        if (level == 0) {
+            // one bit per tile
+            for (int x = 0; x < size; x++) {
+                if (tiles[static_cast<size_t>(y) * tilesPerSide + x]) row[x >> 6] |= 1ull << (x & 63);
+            }
+            continue;
+        }
+
+        const std::vector<uint64_t>& below = levels[level - 1];
+        int belowWords = wordsPerRow[level - 1];
+        const uint64_t* row0 = &below[static_cast<size_t>(2 * y) * belowWords];
+        const uint64_t* row1 = &below[static_cast<size_t>(std::min(2 * y + 1, levelSize[level - 1] - 1)) * belowWords];
+        for (int w = 0; w < wordsPerRow[level]; w++) {
+            uint64_t low = row0[2 * w] | row1[2 * w];
+            uint64_t high = 2 * w + 1 < belowWords ? row0[2 * w + 1] | row1[2 * w + 1] : 0;
+            row[w] = compactPairs(low) | (compactPairs(high) << 32);
+        }
+    }
+}
+
+bool OccupancyRaster::levelBit(int level, int x, int y) const {
+    return (levels[level][static_cast<size_t>(y) * wordsPerRow[level] + (x >> 6)] >> (x & 63)) & 1;
+}
+
+bool OccupancyRaster::texelBounds(const glm::vec2* poly, int count, int& x0, int& y0, int& x1, int& y1) const {
+    glm::vec2 lo = poly[0], hi = poly[0];
+    for (int i = 1; i < count; i++) {
+        lo = glm::min(lo, poly[i]);
+        hi = glm::max(hi, poly[i]);
+    }
+    glm::vec2 u0 = (lo - boxMin) * invTexel;
+    glm::vec2 u1 = (hi - boxMin) * invTexel;
+    x0 = std::max(0, floorToInt(u0.x));
+    y0 = std::max(0, floorToInt(u0.y));
+    x1 = std::min(resolution - 1, floorToInt(u1.x));
+    y1 = std::min(resolution - 1, floorToInt(u1.y));
+    return x0 <= x1 && y0 <= y1;
+}
+
+void OccupancyRaster::rowSpans(const glm::vec2* poly, int count, int y0, int y1, int* first, int* last) const {
+    // x extent on the boundary lines y0..y1 + 1, on the stack for player-sized shapes
+    int lines = y1 - y0 + 2;
+    float stackLeft[stackRows + 1], stackRight[stackRows + 1];
+    thread_local std::vector<float> heapLeft, heapRight;
+    float* lineLeft = stackLeft;
+    float* lineRight = stackRight;
+    if (lines > stackRows + 1) {
+        heapLeft.resize(lines);
+        heapRight.resize(lines);
+        lineLeft = heapLeft.data();
+        lineRight = heapRight.data();
+    }
+    std::fill(lineLeft, lineLeft + lines, INFINITY);
+    std::fill(lineRight, lineRight + lines, -INFINITY);
+
+    for (int i = 0; i < count; i++) {
+        glm::vec2 a = poly[i], b = poly[(i + 1) % count];
+        if (a.y == b.y) continue;
+        if (a.y > b.y) std::swap(a, b);
+        float slope = (b.x - a.x) / (b.y - a.y);
+        int kBegin = std::max(y0, ceilToInt((a.y - boxMin.y) * invTexel));
+        int kEnd = std::min(y1 + 1, floorToInt((b.y - boxMin.y) * invTexel));
+        for (int k = kBegin; k <= kEnd; k++) {
+            float x = a.x + (boxMin.y + k * texel - a.y) * slope;
+            lineLeft[k - y0] = std::min(lineLeft[k - y0], x);
+            lineRight[k - y0] = std::max(lineRight[k - y0], x);
+        }
+    }
+
+    // a row spans its two boundary lines, the line arrays are reused for the row extents
+    int rows = y1 - y0 + 1;
+    for (int r = 0; r < rows; r++) {
+        lineLeft[r] = std::min(lineLeft[r], lineLeft[r + 1]);
+        lineRight[r] = std::max(lineRight[r], lineRight[r + 1]);
+    }
+    for (int i = 0; i < count; i++) {
+        int r = floorToInt((poly[i].y - boxMin.y) * invTexel) - y0;
+        if (r < 0 || r >= rows) continue;
+        lineLeft[r] = std::min(lineLeft[r], poly[i].x);
+        lineRight[r] = std::max(lineRight[r], poly[i].x);
+    }
+
+    for (int r = 0; r < rows; r++) {
+        if (lineLeft[r] > lineRight[r]) {
+            first[r] = 1;
+            last[r] = 0;
+            continue;
+        }
+        first[r] = std::max(0, floorToInt((lineLeft[r] - boxMin.x) * invTexel));
+        last[r] = std::min(resolution - 1, floorToInt((lineRight[r] - boxMin.x) * invTexel));
+    }
+}
+
+bool OccupancyRaster::isOccupied(int x, int y) const {
+    uint64_t tile = tiles[static_cast<size_t>(y / tileSize) * tilesPerSide + x / tileSize];
+    return (tile >> (x % tileSize + tileSize * (y % tileSize))) & 1;
+}
+
+bool OccupancyRaster::overlaps(const glm::vec2* poly, int count, size_t* texels) const {
+    if (texels) *texels = 0;
+    int x0, y0, x1, y1;
+    if (!isBuilt() || !texelBounds(poly, count, x0, y0, x1, y1)) return false;
+
+    // coarsest level where the box spans at most 2 x 2 bits: all clear means no tile to read
+    int tx0 = x0 / tileSize, ty0 = y0 / tileSize, tx1 = x1 / tileSize, ty1 = y1 / tileSize;
+    int level = 0;
+    while (level + 1 < getLevelCount() && ((tx1 >> level) - (tx0 >> level) > 1 || (ty1 >> level) - (ty0 >> level) > 1)) {
+        level++;
+    }
+    bool any = false;
+    for (int y = ty0 >> level; y <= ty1 >> level && !any; y++) {
+        for (int x = tx0 >> level; x <= tx1 >> level && !any; x++) any = levelBit(level, x, y);
+    }
+    if (!any) return false;
+
+    // the player's rows go into one 8 x 8 mask per tile, ANDed with the tile in a single word
+    int stackFirst[stackRows], stackLast[stackRows];
+    thread_local std::vector<int> heapFirst, heapLast;
+    int* first = stackFirst;
+    int* last = stackLast;
+    if (y1 - y0 + 1 > stackRows) {
+        heapFirst.resize(y1 - y0 + 1);
+        heapLast.resize(y1 - y0 + 1);
+        first = heapFirst.data();
+        last = heapLast.data();
+    }
+    rowSpans(poly, count, y0, y1, first, last);
+    size_t covered = 0;
+    for (int ty = ty0; ty <= ty1; ty++) {
+        int rowBegin = std::max(y0, ty * tileSize), rowEnd = std::min(y1, ty * tileSize + 7);
+        int spanBegin = resolution, spanEnd = -1;
+        for (int y = rowBegin; y <= rowEnd; y++) {
+            if (first[y - y0] > last[y - y0]) continue;
+            spanBegin = std::min(spanBegin, first[y - y0]);
+            spanEnd = std::max(spanEnd, last[y - y0]);
+        }
+        const uint64_t* row = &tiles[static_cast<size_t>(ty) * tilesPerSide];
+        for (int tx = spanBegin / tileSize; tx <= spanEnd / tileSize && spanBegin <= spanEnd; tx++) {
+            if (!row[tx]) continue;
+            uint64_t mask = 0;
+            for (int y = rowBegin; y <= rowEnd; y++) {
+                int lo = std::max(first[y - y0], tx * tileSize), hi = std::min(last[y - y0], tx * tileSize + 7);
+                if (lo <= hi) mask |= rowMask(lo - tx * tileSize, hi - tx * tileSize) << (tileSize * (y % tileSize));
+            }
+            covered += popcount(row[tx] & mask);
+            if (covered && !texels) return true;
+        }
+    }
+    if (texels) *texels = covered;
+    return covered > 0;
+}
+
+size_t OccupancyRaster::memoryUsage() const {
+    size_t bytes = tiles.capacity() * sizeof(uint64_t);
+    for (const std::vector<uint64_t>& words : levels) bytes += words.capacity() * sizeof(uint64_t);
+    return bytes;
+}
@@ -0,0 +1,64 @@
+#ifndef OCCUPANCYRASTER_HPP
+#define OCCUPANCYRASTER_HPP
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+class Maze;
+
+// 1-bit occupancy of the level on a square texel grid: a bit is set when a rhombus touches its texel.
+// Each 64-bit word holds an 8 x 8 tile, so a player-sized query reads a few cache lines instead of one per texel
+// row, and a pyramid of "any occupied" levels (one bit per tile, then each bit ORs 2 x 2 bits of the level below)
+// rejects empty regions before the tiles are read. Pose queries rasterize the player the same conservative way
+// into per-tile masks and AND them with the tiles: an overlap is never missed, and a reported one that the exact
+// test rejects has the shapes less than a texel diagonal apart
+class OccupancyRaster {
+public:
+    static const int tileSize = 8;
+    static const int maxLevels = 8;
+
+    OccupancyRaster();
+
+    // Rasterizes every obstacle of a stored layout over [boxMin, boxMax] at resolution x resolution,
+    // bands of tile rows are shared between threadCount workers (0 - one per hardware thread)
+    void build(const Maze& maze, const glm::vec2& boxMin, const glm::vec2& boxMax, int resolution,
+               unsigned int threadCount = 0);
+    void clear();
+
+    bool isBuilt() const { return !tiles.empty(); }
+
+    // Whether the polygon touches a texel that an obstacle touches too. texels (if given) receives the
+    // number of such texels, otherwise the test stops at the first occupied tile
+    bool overlaps(const glm::vec2* poly, int count, size_t* texels = nullptr) const;
+
+    bool isOccupied(int x, int y) const;
+    int getResolution() const { return resolution; }
+    int getLevelCount() const { return static_cast<int>(levels.size()); }
+    float getTexel() const { return texel; }
+    size_t memoryUsage() const;
+
+private:
+    int resolution;
+    int tilesPerSide;
+    glm::vec2 boxMin;
+    float texel;
+    float invTexel;
+    std::vector<uint64_t> tiles;               // tile (tx, ty) at ty * tilesPerSide + tx, bit x + 8 * y inside
+    std::vector<std::vector<uint64_t>> levels; // level k: one bit per 2^k x 2^k tiles, rows packed in words
+    std::vector<int> levelSize;                // bits per side of each level
+    std::vector<int> wordsPerRow;
+
+    void rasterizeBand(const Maze& maze, int tileRowBegin, int tileRowEnd);
+    void buildLevel(int level);
+    bool levelBit(int level, int x, int y) const;
+    // Texel rows and columns the polygon's bounding box touches, false when it misses the grid
+    bool texelBounds(const glm::vec2* poly, int count, int& x0, int& y0, int& x1, int& y1) const;
+    // Texel columns the polygon touches on rows y0..y1 (first > last where it touches none), both arrays hold
+    // y1 - y0 + 1 entries. Each edge is walked once over the row boundaries it crosses, a row takes the extent
+    // on its two boundaries and its vertices
+    void rowSpans(const glm::vec2* poly, int count, int y0, int y1, int* first, int* last) const;
+};
+
+#endif
@@ -0,0 +1,53 @@
+#include "Player.hpp"
+#include "Maze.hpp"
+#include <cmath>
+
+namespace {
+const float PI = 3.14159265358979323846f;
+}
+
+Player::Player()
+    : x(-0.9f), y(-0.9f), angle(-45.0f * PI / 180.0f), moveSpeed(0.02f), rotateSpeed(PI / 120), collisionQueries(0) {
+}
+
+void Player::reset() {
+    *this = Player();
+}
+
+void Player::moveForward(const Maze& maze, float fraction) {
+    moveAlong(maze, 0, fraction);
+}
+
+void Player::moveBackward(const Maze& maze, float fraction) {
+    moveAlong(maze, 2, fraction);
+}
+
+void Player::rotateLeft(const Maze& maze, float fraction) {
+    tryPose(maze, x, y, angle + rotateSpeed * fraction);
+}
+
+void Player::rotateRight(const Maze& maze, float fraction) {
+    tryPose(maze, x, y, angle - rotateSpeed * fraction);
+}
+
+bool Player::reachedFinish(const Maze& maze, float time) const {
+    return maze.playerReachesFinish(x, y, angle, time);
+}
+
+void Player::translate(float dx, float dy) {
+    x += dx;
+    y += dy;
+    if (dx != 0.0f || dy != 0.0f) neighbors.invalidate(); // the cached obstacles are still in the old frame
+}
+
+void Player::moveAlong(const Maze& maze, int localVertex, float fraction) {
+    const glm::vec2& v = maze.getLocal()[localVertex];
+    float dx = (v.x * std::cos(angle) - v.y * std::sin(angle)) * moveSpeed * fraction;
+    float dy = (v.x * std::sin(angle) + v.y * std::cos(angle)) * moveSpeed * fraction;
+    tryPose(maze, x + dx, y + dy, angle);
+}
+
+void Player::tryPose(const Maze& maze, float nextX, float nextY, float nextAngle) {
+    collisionQueries++;
+    maze.slideMove(x, y, angle, nextX, nextY, nextAngle, neighbors);
+}
@@ -0,0 +1,49 @@
+#ifndef PLAYER_HPP
+#define PLAYER_HPP
+
+#include "NeighborCache.hpp"
+
+// Player pose and the four moves bound to the arrow keys. Each move goes through Maze::slideMove,
+// answered from the player's own neighbor cache
+class Player {
+public:
+    Player();
+
+    void reset();
+
+    // Along the rhombus' long diagonal (towards its top or bottom vertex). The speeds are per 60 Hz frame,
+    // fraction scales one move for callers ticking at another rate (60 / rate)
+    void moveForward(const Maze& maze, float fraction = 1.0f);
+    void moveBackward(const Maze& maze, float fraction = 1.0f);
+    void rotateLeft(const Maze& maze, float fraction = 1.0f);
+    void rotateRight(const Maze& maze, float fraction = 1.0f);
+
+    bool reachedFinish(const Maze& maze, float time) const;
+
+    // Shifts the position without a collision test, used when the maze moves its lattice origin
+    void translate(float dx, float dy);
+
+    float getX() const { return x; }
+    float getY() const { return y; }
+    float getAngle() const { return angle; }
+    float getMoveSpeed() const { return moveSpeed; }
+    float getRotateSpeed() const { return rotateSpeed; }
+    // Collision-checked moves so far, each one a sweep and, on contact, a slide
+    size_t getCollisionQueries() const { return collisionQueries; }
+    const NeighborCache& getNeighborCache() const { return neighbors; }
+    NeighborCache& getNeighborCache() { return neighbors; }
+
+private:
+    float x;
+    float y;
+    float angle;
+    float moveSpeed;
+    float rotateSpeed;
+    size_t collisionQueries;
+    NeighborCache neighbors;
+
+    void moveAlong(const Maze& maze, int localVertex, float fraction);
+    void tryPose(const Maze& maze, float nextX, float nextY, float nextAngle);
+};
+
+#endif
@@ -0,0 +1,96 @@
+#include "RenderTargetPool.hpp"
+#include <glad/glad.h>
+#include <algorithm>
+#include <iostream>
+
+RenderTargetPool::RenderTargetPool()
+    : allocations(0), reuses(0) {
+}
+
+RenderTarget* RenderTargetPool::acquire(int width, int height, unsigned int format) {
+    for (const std::unique_ptr<Slot>& slot : slots) {
+        if (!slot->inUse && slot->target.width == width && slot->target.height == height && slot->target.format == format) {
+            slot->inUse = true;
+            slot->idleFrames = 0;
+            reuses++;
+            return &slot->target;
+        }
+    }
+
+    slots.push_back(std::make_unique<Slot>(Slot{ RenderTarget{ 0, 0, width, height, format }, true, 0 }));
+    RenderTarget& target = slots.back()->target;
+    glGenFramebuffers(1, &target.framebuffer);
+    glGenTextures(1, &target.texture);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, target.framebuffer);
+    glBindTexture(GL_TEXTURE_2D, target.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture, 0);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Framebuffer is not complete!" << std::endl;
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    allocations++;
+    return &target;
+}
+
+void RenderTargetPool::release(RenderTarget* target) {
+    for (const std::unique_ptr<Slot>& slot : slots) {
+        if (&slot->target == target) slot->inUse = false;
+    }
+}
+
+void RenderTargetPool::endFrame(int maxIdleFrames) {
+    for (size_t i = 0; i < slots.size();) {
+        Slot& slot = *slots[i];
+        if (!slot.inUse && ++slot.idleFrames > maxIdleFrames) {
+            deleteTarget(slot.target);
+            slots.erase(slots.begin() + i);
+        } else {
+            i++;
+        }
+    }
+}
+
+void RenderTargetPool::destroy() {
+    for (const std::unique_ptr<Slot>& slot : slots) deleteTarget(slot->target);
+    slots.clear();
+}
+
+void RenderTargetPool::deleteTarget(RenderTarget& target) {
+    glDeleteTextures(1, &target.texture);
+    glDeleteFramebuffers(1, &target.framebuffer);
+}
+
+ResolutionController::ResolutionController(float targetMs, float minScale, float maxScale)
+    : targetMs(targetMs), minScale(minScale), maxScale(maxScale), scale(maxScale), smoothedMs(targetMs), cooldown(0) {
+}
+
+float ResolutionController::update(float frameMs) {
+    smoothedMs += (frameMs - smoothedMs) * 0.1f;
+    if (cooldown > 0) {
+        cooldown--;
+        return scale;
+    }
+
+    const float step = 0.05f;
+    if (smoothedMs > targetMs * 1.05f && scale > minScale) {
+        scale = std::max(minScale, scale - step);
+        cooldown = 15;
+    } else if (smoothedMs < targetMs * 0.8f && scale < maxScale) {
+        // growing is slower than shrinking, a too-high scale costs frames while a low one only costs sharpness
+        scale = std::min(maxScale, scale + step);
+        cooldown = 60;
+    }
+    return scale;
+}
+
+void ResolutionController::setScale(float scale) {
+    this->scale = std::min(maxScale, std::max(minScale, scale));
+}
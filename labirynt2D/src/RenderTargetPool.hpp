@@ -0,0 +1,70 @@
+#ifndef RENDERTARGETPOOL_HPP
+#define RENDERTARGETPOOL_HPP
+
+#include <memory>
+#include <vector>
+
+// Colour texture with its framebuffer
+struct RenderTarget {
+    unsigned int framebuffer;
+    unsigned int texture;
+    int width;
+    int height;
+    unsigned int format; // internal format, e.g. GL_RGB8
+};
+
+// Owns the off-screen targets of the post-process pass. A target asked for with the size and format of a
+// released one gets it back instead of a new allocation, so resizing or changing the render scale back and
+// forth does not reallocate every time. Targets left unused for a while are deleted.
+class RenderTargetPool {
+public:
+    RenderTargetPool();
+
+    // A target of exactly this size and format, reused when one is free
+    RenderTarget* acquire(int width, int height, unsigned int format);
+    void release(RenderTarget* target);
+
+    // Called once a frame: deletes free targets idle for more than maxIdleFrames
+    void endFrame(int maxIdleFrames = 120);
+    void destroy();
+
+    int getAllocations() const { return allocations; }
+    int getReuses() const { return reuses; }
+
+private:
+    struct Slot {
+        RenderTarget target;
+        bool inUse;
+        int idleFrames;
+    };
+
+    std::vector<std::unique_ptr<Slot>> slots; // boxed, so handed-out targets stay put when the vector grows
+    int allocations;
+    int reuses;
+
+    void deleteTarget(RenderTarget& target);
+};
+
+// Dynamic resolution: keeps a smoothed frame time and moves the render scale down when it exceeds the target,
+// back up once there is clear headroom. Adjustments wait a few frames so one slow frame does not flicker it
+class ResolutionController {
+public:
+    ResolutionController(float targetMs = 1000.0f / 60.0f, float minScale = 0.5f, float maxScale = 1.0f);
+
+    // Feeds the last frame time, returns the render scale for the next frame
+    float update(float frameMs);
+
+    float getScale() const { return scale; }
+    float getSmoothedMs() const { return smoothedMs; }
+    void setScale(float scale);
+
+private:
+    float targetMs;
+    float minScale;
+    float maxScale;
+    float scale;
+    float smoothedMs;
+    int cooldown; // frames until the next adjustment is allowed
+};
+
+#endif
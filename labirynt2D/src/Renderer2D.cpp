@@ -0,0 +1,118 @@
+#include "Renderer2D.hpp"
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+#include "shader_utils.h"
+
+Renderer2D::Renderer2D()
+    : program(0), vao(0), vbo(0), fieldTexture(0), capacity(0), staticCount(0), staticDirty(false),
+      cameraLoc(-1), timeLoc(-1), brightnessLoc(-1), drawCalls(0), frames(0), submitSeconds(0.0) {
+}
+
+void Renderer2D::destroy() {
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vbo);
+    glDeleteTextures(1, &fieldTexture);
+    glDeleteProgram(program);
+}
+
+void Renderer2D::init(const Maze& maze) {
+    program = createShaderProgram("../shaders/batch_vertex.glsl", "../shaders/batch_fragment.glsl");
+    cameraLoc = glGetUniformLocation(program, "cameraOffset");
+    timeLoc = glGetUniformLocation(program, "time");
+    brightnessLoc = glGetUniformLocation(program, "playerBrightness");
+
+    // Shapes never change during a level, they are uniforms set once
+    glUseProgram(program);
+    glUniform2fv(glGetUniformLocation(program, "rhombusLocal"), 4, &maze.getLocal()[0].x);
+    Triangle finish = maze.finishTriangleAt(0.0f);
+    glm::vec2 finishCenter = maze.getFinishCenter();
+    for (int i = 0; i < 3; i++) finish[i] -= finishCenter;
+    glUniform2fv(glGetUniformLocation(program, "finishLocal"), 3, &finish[0].x);
+
+    // Signed distance field of a stored layout drives the background glow
+    const DistanceField& field = maze.getDistanceField();
+    glGenTextures(1, &fieldTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, fieldTexture);
+    if (field.isBaked()) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, field.getResolution(), field.getResolution(), 0, GL_RED, GL_FLOAT, field.getValues().data());
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glActiveTexture(GL_TEXTURE0); // the post-process texture stays on unit 0
+
+    glUniform1i(glGetUniformLocation(program, "distanceField"), 1);
+    glUniform1i(glGetUniformLocation(program, "hasField"), field.isBaked());
+    glUniform2f(glGetUniformLocation(program, "fieldMin"), field.getBoxMin().x, field.getBoxMin().y);
+    glUniform2f(glGetUniformLocation(program, "fieldSize"), field.getBoxMax().x - field.getBoxMin().x,
+                field.getBoxMax().y - field.getBoxMin().y);
+    glUniform1f(glGetUniformLocation(program, "glowRadius"), maze.getLongDiag() * 0.3f);
+
+    // No per-vertex data at all, the shader builds every shape from gl_VertexID and the primitive record
+    glGenVertexArrays(1, &vao);
+    glGenBuffers(1, &vbo);
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Primitive), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribDivisor(0, 1);
+}
+
+void Renderer2D::setStatic(const std::vector<ObstacleInstance>& obstacles) {
+    primitives.clear();
+    primitives.push_back(Primitive{ glm::vec2(0.0f), 0.0f, static_cast<float>(PrimitiveKind::Background) });
+    for (const ObstacleInstance& obstacle : obstacles) {
+        primitives.push_back(Primitive{ obstacle.center, obstacle.angle, static_cast<float>(PrimitiveKind::Obstacle) });
+    }
+    staticCount = primitives.size();
+    staticDirty = true;
+}
+
+void Renderer2D::beginFrame() {
+    primitives.resize(staticCount);
+}
+
+void Renderer2D::add(PrimitiveKind kind, const glm::vec2& center, float angle) {
+    primitives.push_back(Primitive{ center, angle, static_cast<float>(kind) });
+}
+
+void Renderer2D::addAgents(const std::vector<ObstacleInstance>& agents) {
+    for (const ObstacleInstance& agent : agents) {
+        primitives.push_back(Primitive{ agent.center, agent.angle, static_cast<float>(PrimitiveKind::Agent) });
+    }
+}
+
+void Renderer2D::draw(const glm::vec2& camera, float time, float playerBrightness) {
+    double start = glfwGetTime();
+
+    glBindBuffer(GL_ARRAY_BUFFER, vbo);
+    if (primitives.size() > capacity) {
+        // grow with headroom so a few more agents or visible cells do not reallocate every frame
+        capacity = primitives.size() + primitives.size() / 2;
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(Primitive), nullptr, GL_DYNAMIC_DRAW);
+        staticDirty = true;
+    }
+    size_t uploadFrom = staticDirty ? 0 : staticCount;
+    glBufferSubData(GL_ARRAY_BUFFER, uploadFrom * sizeof(Primitive), (primitives.size() - uploadFrom) * sizeof(Primitive),
+                    primitives.data() + uploadFrom);
+    staticDirty = false;
+
+    glUseProgram(program);
+    glUniform2f(cameraLoc, camera.x, camera.y);
+    glUniform1f(timeLoc, time);
+    glUniform1f(brightnessLoc, playerBrightness);
+    glBindVertexArray(vao);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 6, static_cast<GLsizei>(primitives.size()));
+    drawCalls++;
+
+    submitSeconds += glfwGetTime() - start;
+    frames++;
+}
+
+void Renderer2D::resetStats() {
+    drawCalls = 0;
+    frames = 0;
+    submitSeconds = 0.0;
+}
@@ -0,0 +1,73 @@
+#ifndef RENDERER2D_HPP
+#define RENDERER2D_HPP
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstddef>
+#include "Maze.hpp"
+
+// What a primitive is drawn as. The uber-shader picks the shape (rhombus, triangle or quad) and the colouring
+enum class PrimitiveKind {
+    Background = 0,
+    Obstacle = 1,
+    Agent = 2,
+    Finish = 3,
+    Player = 4
+};
+
+// One 16-byte record per primitive, the only vertex data streamed to the GPU
+struct Primitive {
+    glm::vec2 center;
+    float angle;
+    float kind;
+};
+
+// Batched renderer of the level: one uber-shader, one instance buffer, one instanced draw per frame. The
+// background and (in a stored maze) the obstacles sit at the front of the buffer and are uploaded once;
+// agents, the finish marker and the player are appended every frame and streamed behind them.
+class Renderer2D {
+public:
+    Renderer2D();
+
+    // Compiles the shader, caches every uniform location and uploads the distance field for the glow
+    void init(const Maze& maze);
+
+    // Background plus the given obstacles. Called once for a stored maze, every frame for an implicit one
+    void setStatic(const std::vector<ObstacleInstance>& obstacles);
+
+    void beginFrame();
+    void add(PrimitiveKind kind, const glm::vec2& center, float angle);
+    void addAgents(const std::vector<ObstacleInstance>& agents);
+
+    // Submits everything in one draw, positions relative to the camera
+    void draw(const glm::vec2& camera, float time, float playerBrightness);
+
+    // Deletes the GL objects, called while the context is still alive
+    void destroy();
+
+    int getDrawCalls() const { return drawCalls; }
+    // Average CPU time of draw() (buffer upload and submission) since the last resetStats
+    double getAverageSubmitMs() const { return frames ? submitSeconds * 1000.0 / frames : 0.0; }
+    size_t getPrimitiveCount() const { return primitives.size(); }
+    void resetStats();
+
+private:
+    unsigned int program;
+    unsigned int vao;
+    unsigned int vbo;
+    unsigned int fieldTexture;
+    size_t capacity;   // primitives the buffer can hold
+    size_t staticCount;
+    bool staticDirty;
+    std::vector<Primitive> primitives;
+
+    int cameraLoc;
+    int timeLoc;
+    int brightnessLoc;
+
+    int drawCalls;
+    int frames;
+    double submitSeconds;
+};
+
+#endif
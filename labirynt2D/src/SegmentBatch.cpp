@@ -0,0 +1,216 @@
+#include "SegmentBatch.hpp"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define SEGMENT_BATCH_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang compile the AVX2 kernel for its own target only, the rest of the file stays baseline x86
+#if defined(SEGMENT_BATCH_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SEGMENT_BATCH_AVX2 __attribute__((target("avx2")))
+#else
+#define SEGMENT_BATCH_AVX2
+#endif
+
+void EdgeBatch::clear() {
+    ax.clear();
+    ay.clear();
+    dx.clear();
+    dy.clear();
+    count = 0;
+}
+
+void EdgeBatch::addPolygon(const glm::vec2* poly, int count) {
+    // drop the padding of the last block, the new edges take its place
+    ax.resize(this->count);
+    ay.resize(this->count);
+    dx.resize(this->count);
+    dy.resize(this->count);
+    for (int i = 0; i < count; i++) {
+        glm::vec2 a = poly[i];
+        glm::vec2 edge = poly[(i + 1) % count] - a;
+        ax.push_back(a.x);
+        ay.push_back(a.y);
+        dx.push_back(edge.x);
+        dy.push_back(edge.y);
+    }
+    this->count += count;
+
+    // a zero-length edge is parallel to everything and never crosses
+    size_t padded = (this->count + blockSize - 1) / blockSize * blockSize;
+    ax.resize(padded, 0.0f);
+    ay.resize(padded, 0.0f);
+    dx.resize(padded, 0.0f);
+    dy.resize(padded, 0.0f);
+}
+
+size_t EdgeBatch::memoryUsage() const {
+    return (ax.capacity() + ay.capacity() + dx.capacity() + dy.capacity()) * sizeof(float);
+}
+
+namespace {
+
+bool crossingsScalar(const glm::vec2& p1, const glm::vec2& d, const EdgeBatch& edges, uint8_t* masks) {
+    bool any = false;
+    for (size_t block = 0; block < edges.blockCount(); block++) {
+        unsigned mask = 0;
+        for (size_t k = 0; k < EdgeBatch::blockSize; k++) {
+            size_t e = block * EdgeBatch::blockSize + k;
+            float pqx = edges.ax[e] - p1.x;
+            float pqy = edges.ay[e] - p1.y;
+            float den = d.x * edges.dy[e] - d.y * edges.dx[e];
+            float tNum = pqx * edges.dy[e] - pqy * edges.dx[e];
+            float uNum = pqx * d.y - pqy * d.x;
+            if (den < 0) {
+                den = -den;
+                tNum = -tNum;
+                uNum = -uNum;
+            }
+            if (den > 0 && tNum >= 0 && tNum <= den && uNum >= 0 && uNum <= den) mask |= 1u << k;
+        }
+        if (mask) {
+            any = true;
+            if (!masks) return true;
+        }
+        if (masks) masks[block] = (uint8_t)mask;
+    }
+    return any;
+}
+
+#ifdef SEGMENT_BATCH_X86
+
+// Four edges per step: the sign bit of den flips tNum and uNum and leaves |den|, so the range checks are
+// plain ordered compares
+inline unsigned crossMaskSSE(const EdgeBatch& edges, size_t e, __m128 p1x, __m128 p1y, __m128 segX, __m128 segY) {
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+    const __m128 zero = _mm_setzero_ps();
+    __m128 ex = _mm_loadu_ps(&edges.dx[e]);
+    __m128 ey = _mm_loadu_ps(&edges.dy[e]);
+    __m128 pqx = _mm_sub_ps(_mm_loadu_ps(&edges.ax[e]), p1x);
+    __m128 pqy = _mm_sub_ps(_mm_loadu_ps(&edges.ay[e]), p1y);
+
+    __m128 den = _mm_sub_ps(_mm_mul_ps(segX, ey), _mm_mul_ps(segY, ex));
+    __m128 tNum = _mm_sub_ps(_mm_mul_ps(pqx, ey), _mm_mul_ps(pqy, ex));
+    __m128 uNum = _mm_sub_ps(_mm_mul_ps(pqx, segY), _mm_mul_ps(pqy, segX));
+
+    __m128 sign = _mm_and_ps(den, signBit);
+    den = _mm_xor_ps(den, sign);
+    tNum = _mm_xor_ps(tNum, sign);
+    uNum = _mm_xor_ps(uNum, sign);
+
+    __m128 hit = _mm_cmpgt_ps(den, zero);
+    hit = _mm_and_ps(hit, _mm_cmpge_ps(tNum, zero));
+    hit = _mm_and_ps(hit, _mm_cmple_ps(tNum, den));
+    hit = _mm_and_ps(hit, _mm_cmpge_ps(uNum, zero));
+    hit = _mm_and_ps(hit, _mm_cmple_ps(uNum, den));
+    return (unsigned)_mm_movemask_ps(hit);
+}
+
+bool crossingsSSE(const glm::vec2& p1, const glm::vec2& d, const EdgeBatch& edges, uint8_t* masks) {
+    __m128 p1x = _mm_set1_ps(p1.x), p1y = _mm_set1_ps(p1.y);
+    __m128 segX = _mm_set1_ps(d.x), segY = _mm_set1_ps(d.y);
+    bool any = false;
+    for (size_t block = 0; block < edges.blockCount(); block++) {
+        size_t e = block * EdgeBatch::blockSize;
+        unsigned mask = crossMaskSSE(edges, e, p1x, p1y, segX, segY) |
+                        crossMaskSSE(edges, e + 4, p1x, p1y, segX, segY) << 4;
+        if (mask) {
+            any = true;
+            if (!masks) return true;
+        }
+        if (masks) masks[block] = (uint8_t)mask;
+    }
+    return any;
+}
+
+SEGMENT_BATCH_AVX2
+bool crossingsAVX2(const glm::vec2& p1, const glm::vec2& d, const EdgeBatch& edges, uint8_t* masks) {
+    const __m256 signBit = _mm256_set1_ps(-0.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 p1x = _mm256_set1_ps(p1.x), p1y = _mm256_set1_ps(p1.y);
+    __m256 segX = _mm256_set1_ps(d.x), segY = _mm256_set1_ps(d.y);
+    bool any = false;
+    for (size_t block = 0; block < edges.blockCount(); block++) {
+        size_t e = block * EdgeBatch::blockSize;
+        __m256 ex = _mm256_loadu_ps(&edges.dx[e]);
+        __m256 ey = _mm256_loadu_ps(&edges.dy[e]);
+        __m256 pqx = _mm256_sub_ps(_mm256_loadu_ps(&edges.ax[e]), p1x);
+        __m256 pqy = _mm256_sub_ps(_mm256_loadu_ps(&edges.ay[e]), p1y);
+
+        __m256 den = _mm256_sub_ps(_mm256_mul_ps(segX, ey), _mm256_mul_ps(segY, ex));
+        __m256 tNum = _mm256_sub_ps(_mm256_mul_ps(pqx, ey), _mm256_mul_ps(pqy, ex));
+        __m256 uNum = _mm256_sub_ps(_mm256_mul_ps(pqx, segY), _mm256_mul_ps(pqy, segX));
+
+        __m256 sign = _mm256_and_ps(den, signBit);
+        den = _mm256_xor_ps(den, sign);
+        tNum = _mm256_xor_ps(tNum, sign);
+        uNum = _mm256_xor_ps(uNum, sign);
+
+        __m256 hit = _mm256_cmp_ps(den, zero, _CMP_GT_OQ);
+        hit = _mm256_and_ps(hit, _mm256_cmp_ps(tNum, zero, _CMP_GE_OQ));
+        hit = _mm256_and_ps(hit, _mm256_cmp_ps(tNum, den, _CMP_LE_OQ));
+        hit = _mm256_and_ps(hit, _mm256_cmp_ps(uNum, zero, _CMP_GE_OQ));
+        hit = _mm256_and_ps(hit, _mm256_cmp_ps(uNum, den, _CMP_LE_OQ));
+        unsigned mask = (unsigned)_mm256_movemask_ps(hit);
+        if (mask) {
+            any = true;
+            if (!masks) return true;
+        }
+        if (masks) masks[block] = (uint8_t)mask;
+    }
+    return any;
+}
+
+bool cpuHasAVX2() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    bool osSavesYmm = (info[2] & (1 << 27)) && (_xgetbv(0) & 6) == 6; // OSXSAVE, XMM and YMM state enabled
+    if (!osSavesYmm) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+}
+
+SegmentKernel bestSegmentKernel() {
+#ifdef SEGMENT_BATCH_X86
+    static const SegmentKernel best = cpuHasAVX2() ? SegmentKernel::AVX2 : SegmentKernel::SSE;
+    return best;
+#else
+    return SegmentKernel::Scalar;
+#endif
+}
+
+const char* segmentKernelName(SegmentKernel kernel) {
+    switch (kernel) {
+    case SegmentKernel::AVX2: return "AVX2";
+    case SegmentKernel::SSE: return "SSE";
+    default: return "scalar";
+    }
+}
+
+bool segmentCrossings(const glm::vec2& p1, const glm::vec2& p2, const EdgeBatch& edges, uint8_t* masks,
+                      SegmentKernel kernel) {
+    glm::vec2 d = p2 - p1;
+#ifdef SEGMENT_BATCH_X86
+    if (kernel == SegmentKernel::AVX2) return crossingsAVX2(p1, d, edges, masks);
+    if (kernel == SegmentKernel::SSE) return crossingsSSE(p1, d, edges, masks);
+#endif
+    return crossingsScalar(p1, d, edges, masks);
+}
+
+bool polygonCrossesEdges(const glm::vec2* poly, int count, const EdgeBatch& edges, SegmentKernel kernel) {
+    for (int i = 0; i < count; i++) {
+        if (segmentCrossings(poly[i], poly[(i + 1) % count], edges, nullptr, kernel)) return true;
+    }
+    return false;
+}
@@ -0,0 +1,46 @@
+#ifndef SEGMENTBATCH_HPP
+#define SEGMENTBATCH_HPP
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Obstacle edges in structure-of-arrays form: start point and direction in separate float arrays, padded with
+// zero-length edges to whole blocks of 8 so the SIMD kernels load them without a scalar tail
+struct EdgeBatch {
+    static const size_t blockSize = 8;
+
+    std::vector<float> ax, ay; // edge start
+    std::vector<float> dx, dy; // edge end minus start
+    size_t count = 0;          // real edges, the rest up to the block boundary is padding
+
+    void clear();
+    // Appends the closed outline of a polygon (count edges)
+    void addPolygon(const glm::vec2* poly, int count);
+    size_t blockCount() const { return ax.size() / blockSize; }
+    size_t memoryUsage() const;
+};
+
+enum class SegmentKernel {
+    Scalar,
+    SSE,
+    AVX2
+};
+
+// Widest kernel this CPU runs, checked once at startup
+SegmentKernel bestSegmentKernel();
+const char* segmentKernelName(SegmentKernel kernel);
+
+// Division-free test of segment p1-p2 against every edge of the batch, with the same inclusive ends and
+// parallel rule as segmentsIntersect. With masks == nullptr returns at the first crossing; otherwise writes
+// one byte per block (bit k - edge k of the block crosses) and returns whether any edge does
+bool segmentCrossings(const glm::vec2& p1, const glm::vec2& p2, const EdgeBatch& edges, uint8_t* masks,
+                      SegmentKernel kernel = bestSegmentKernel());
+
+// Whether any edge of the polygon crosses an edge of the batch. For two congruent shapes (the player and the
+// obstacles) this is the overlap test: neither can contain the other, so overlapping outlines always cross
+bool polygonCrossesEdges(const glm::vec2* poly, int count, const EdgeBatch& edges,
+                         SegmentKernel kernel = bestSegmentKernel());
+
+#endif
@@ -0,0 +1,155 @@
+#include "Simulation.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace {
+// Rate the player and agent speeds were tuned for (one move per vsynced frame)
+const int referenceRate = 60;
+// Falling further behind than this drops the backlog instead of running it back to back
+const size_t maxCatchUpTicks = 60;
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+}
+
+Simulation::Simulation(Maze& maze, AgentSwarm& swarm, int tickRate)
+    : maze(maze), swarm(swarm), tickRate(std::max(1, tickRate)),
+      swarmDivider(std::max(1, this->tickRate / referenceRate)),
+      finishVisible(true), won(false), winTime(0.0), finishTick(InputRecording::notFinished), swarmSteps(0),
+      swarmSeconds(0.0), running(false), input(0), epoch(std::chrono::steady_clock::now()), recording(nullptr),
+      nextTick(0), sharedFresh(false),
+      ticks(0), skippedTicks(0), tickSeconds(0.0) {
+}
+
+Simulation::~Simulation() {
+    stop();
+}
+
+void Simulation::start() {
+    if (running.exchange(true)) return;
+    epoch = std::chrono::steady_clock::now();
+    worker = std::thread([this]() { run(); });
+}
+
+void Simulation::stop() {
+    running.store(false);
+    if (!worker.joinable()) return;
+    worker.join();
+    if (recording) {
+        recording->end(nextTick, glm::vec2(player.getX(), player.getY()), player.getAngle(), finishTick);
+    }
+}
+
+bool Simulation::latest(SimulationSnapshot& front) {
+    std::lock_guard<std::mutex> lock(sharedMutex);
+    if (!sharedFresh) return false;
+    std::swap(front, shared);
+    sharedFresh = false;
+    return true;
+}
+
+double Simulation::now() const {
+    return secondsSince(epoch);
+}
+
+void Simulation::run() {
+    const double tickDuration = getTickSeconds();
+    size_t& tick = nextTick;
+    while (running.load()) {
+        double due = tick * tickDuration;
+        double current = now();
+        if (current < due) {
+            std::this_thread::sleep_until(epoch + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                                      std::chrono::duration<double>(due)));
+            continue;
+        }
+
+        // a stall (window drag, debugger) skips the missed ticks, game time keeps following the clock
+        size_t reached = static_cast<size_t>(current / tickDuration);
+        if (reached > tick + maxCatchUpTicks) {
+            skippedTicks += reached - tick;
+            if (recording) recording->recordSkip(tick, reached - tick);
+            tick = reached;
+        }
+
+        unsigned int keys = input.load(std::memory_order_relaxed);
+        if (recording) recording->recordTick(tick, keys);
+        auto start = std::chrono::steady_clock::now();
+        step(tick, keys);
+        publish();
+        tickSeconds += secondsSince(start);
+        ticks++;
+        tick++;
+    }
+}
+
+void Simulation::advance(size_t tick, unsigned int keys) {
+    if (tick > nextTick) skippedTicks += tick - nextTick;
+    auto start = std::chrono::steady_clock::now();
+    step(tick, keys);
+    tickSeconds += secondsSince(start);
+    ticks++;
+    nextTick = tick + 1;
+}
+
+void Simulation::step(size_t tick, unsigned int keys) {
+    double time = tick * getTickSeconds();
+    float fraction = static_cast<float>(referenceRate) / tickRate;
+
+    back.previousPosition = glm::vec2(player.getX(), player.getY());
+    back.previousAngle = player.getAngle();
+    back.time = time;
+
+    if (keys & KeyWin) won = true;
+
+    // Player input only when the game is in progress
+    if (!won) {
+        if (keys & KeyUp) player.moveForward(maze, fraction);
+        if (keys & KeyDown) player.moveBackward(maze, fraction);
+        if (keys & KeyLeft) player.rotateLeft(maze, fraction);
+        if (keys & KeyRight) player.rotateRight(maze, fraction);
+
+        // keep the player's local coordinates small, the lattice origin follows it through an implicit maze
+        glm::vec2 shift = maze.recenter(player.getX(), player.getY());
+        player.translate(-shift.x, -shift.y);
+        swarm.translate(-shift.x, -shift.y);
+        back.previousPosition -= shift;
+    }
+
+    // Stress mode: every agent moves once per reference frame
+    if (swarm.size() > 0 && tick % swarmDivider == 0) {
+        auto start = std::chrono::steady_clock::now();
+        swarm.tick(maze, static_cast<float>(time));
+        swarmSeconds += secondsSince(start);
+        swarmSteps += swarm.size();
+    }
+
+    if (finishVisible && !won && player.reachedFinish(maze, static_cast<float>(time))) {
+        finishVisible = false;
+        won = true;
+        winTime = time;
+        finishTick = static_cast<int64_t>(tick);
+    }
+}
+
+void Simulation::publish() {
+    back.position = glm::vec2(player.getX(), player.getY());
+    back.angle = player.getAngle();
+    back.finishCenter = maze.getFinishCenter();
+    back.finishVisible = finishVisible;
+    back.won = won;
+    back.winTime = winTime;
+    back.swarmSteps = swarmSteps;
+    back.swarmSeconds = swarmSeconds;
+    back.arrivals = swarm.getArrivals();
+    if (swarm.size() > 0) swarm.collectInstances(back.agents);
+    // one screen around the player plus a rhombus of margin, enough for the interpolated camera too
+    if (maze.isImplicit()) {
+        maze.collectInstances(back.position - glm::vec2(1.0f), back.position + glm::vec2(1.0f), back.visible);
+    }
+
+    std::lock_guard<std::mutex> lock(sharedMutex);
+    std::swap(back, shared);
+    sharedFresh = true;
+}
@@ -0,0 +1,127 @@
+#ifndef SIMULATION_HPP
+#define SIMULATION_HPP
+
+#include <glm/glm.hpp>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include "Maze.hpp"
+#include "Player.hpp"
+#include "AgentSwarm.hpp"
+#include "InputRecording.hpp"
+
+// Keys held during a tick, set by the window thread (GLFW input is polled there)
+enum InputKey : unsigned int {
+    KeyUp = 1,
+    KeyDown = 2,
+    KeyLeft = 4,
+    KeyRight = 8,
+    KeyWin = 16 // debug: finish the level at once
+};
+
+// Everything the render loop needs from one tick. The previous pose is in the same lattice frame as the
+// current one, so the two can be interpolated even across a recenter of an implicit maze
+struct SimulationSnapshot {
+    glm::vec2 previousPosition = glm::vec2(0.0f);
+    float previousAngle = 0.0f;
+    glm::vec2 position = glm::vec2(0.0f);
+    float angle = 0.0f;
+    double time = 0.0; // simulation seconds of this tick
+
+    glm::vec2 finishCenter = glm::vec2(0.0f);
+    bool finishVisible = true;
+    bool won = false;
+    double winTime = 0.0;
+
+    std::vector<ObstacleInstance> agents;
+    std::vector<ObstacleInstance> visible; // implicit mode: obstacles around the player
+
+    // stress mode totals since the start
+    size_t swarmSteps = 0;
+    double swarmSeconds = 0.0;
+    size_t arrivals = 0;
+};
+
+// Player, agents and the finish test advanced at a fixed rate on their own thread, so the game runs at the same
+// speed whatever the frame rate and the simulation cost is measured apart from rendering. Each tick fills a
+// back snapshot and swaps it with the shared one; the render loop swaps the shared one out for its front.
+// The maze and swarm belong to the simulation thread between start() and stop()
+class Simulation {
+public:
+    static const int defaultTickRate = 240;
+
+    Simulation(Maze& maze, AgentSwarm& swarm, int tickRate = defaultTickRate);
+    ~Simulation();
+
+    void start();
+    void stop();
+
+    void setInput(unsigned int keys) { input.store(keys, std::memory_order_relaxed); }
+
+    // Keys of every tick and the ticks skipped after stalls go to the recording until stop(), which closes it
+    // with the tick count and final pose. Set before start()
+    void setRecording(InputRecording* recording) { this->recording = recording; }
+
+    // Headless: runs one tick with the given keys on the caller's thread, without publishing a snapshot.
+    // Ticks in increasing order, gaps act like skipped ticks. Not while the thread is running
+    void advance(size_t tick, unsigned int keys);
+
+    // Swaps in the newest snapshot when a tick published one since the last call, front keeps its old
+    // contents otherwise. Returns whether it changed
+    bool latest(SimulationSnapshot& front);
+
+    // Simulation clock: seconds since start(), ticks run at whole multiples of getTickSeconds()
+    double now() const;
+    double getTickSeconds() const { return 1.0 / tickRate; }
+    int getTickRate() const { return tickRate; }
+
+    // Only valid while the thread is stopped
+    size_t getTicks() const { return ticks; }
+    size_t getSkippedTicks() const { return skippedTicks; }
+    double getAverageTickMs() const { return ticks ? tickSeconds * 1000.0 / ticks : 0.0; }
+    const Player& getPlayer() const { return player; }
+    bool isWon() const { return won; }
+    // Tick the finish was reached at, InputRecording::notFinished before
+    int64_t getFinishTick() const { return finishTick; }
+
+private:
+    Maze& maze;
+    AgentSwarm& swarm;
+    Player player;
+    int tickRate;
+    int swarmDivider; // agents keep the 60 Hz they were tuned for
+
+    // game state carried from tick to tick, copied into every snapshot
+    bool finishVisible;
+    bool won;
+    double winTime;
+    int64_t finishTick;
+    size_t swarmSteps;
+    double swarmSeconds;
+
+    std::thread worker;
+    std::atomic<bool> running;
+    std::atomic<unsigned int> input;
+    std::chrono::steady_clock::time_point epoch;
+    InputRecording* recording;
+    size_t nextTick; // first tick not run yet
+
+    SimulationSnapshot back;
+    SimulationSnapshot shared;
+    bool sharedFresh;
+    std::mutex sharedMutex;
+
+    size_t ticks;
+    size_t skippedTicks;
+    double tickSeconds;
+
+    void run();
+    // Game update of one tick, publish() hands its result to the render loop
+    void step(size_t tick, unsigned int keys);
+    void publish();
+};
+
+#endif
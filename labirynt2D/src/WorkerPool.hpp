@@ -0,0 +1,40 @@
+#ifndef WORKERPOOL_HPP
+#define WORKERPOOL_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Threads kept alive between parallel passes that run every frame or tick, so a pass pays a wake-up instead of
+// thread creation. Idle threads sleep on a condition variable
+class WorkerPool {
+public:
+    // threadCount threads including the caller's (0 - one per hardware thread)
+    explicit WorkerPool(unsigned int threadCount = 0);
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Calls job(t) once for every t in [0, size()), job(0) on the calling thread, and returns when all are done
+    void run(const std::function<void(unsigned int)>& job);
+
+    unsigned int size() const { return threadCount; }
+
+private:
+    unsigned int threadCount;
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    const std::function<void(unsigned int)>* job;
+    uint64_t generation; // run() calls so far, a thread works once per generation
+    unsigned int busy;   // pool threads still inside the current job
+    bool quitting;
+
+    void loop(unsigned int t);
+};
+
+#endif